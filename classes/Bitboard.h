@@ -3,6 +3,8 @@
 #ifdef _MSC_VER
 #include <intrin.h>
 #endif
+#include <bit>
+#include <cstdint>
 #include <iostream>
 
 enum ChessPiece
@@ -16,6 +18,13 @@ enum ChessPiece
     King
 };
 
+// raw bitboard helpers for the hot paths that work on plain uint64_t
+inline int popCount(uint64_t bb) { return std::popcount(bb); }
+// index of the lowest set bit, bb must not be 0
+inline int lsb(uint64_t bb) { return std::countr_zero(bb); }
+// index of the lowest set bit, which is also cleared
+inline int popLsb(uint64_t &bb) { int index = std::countr_zero(bb); bb &= bb - 1; return index; }
+
 class BitboardElement {
   public:
     // Constructors
@@ -83,19 +92,35 @@ private:
 
 };
 
+// special move kinds, the promotion piece is stored in the upper nibble of flags
+enum BitMoveFlags
+{
+    MoveNormal = 0,
+    MoveDoublePush = 1,
+    MoveCastle = 2,
+    MoveEnPassant = 3,
+    MovePromotion = 4
+};
+
 struct BitMove {
     uint8_t from;
     uint8_t to;
     uint8_t piece;
+    uint8_t flags;
     
-    BitMove(int from, int to, ChessPiece piece)
-        : from(from), to(to), piece(piece) { }
+    BitMove(int from, int to, ChessPiece piece, int flags = MoveNormal)
+        : from(from), to(to), piece(piece), flags(flags) { }
         
-    BitMove() : from(0), to(0), piece(NoPiece) { }
+    BitMove() : from(0), to(0), piece(NoPiece), flags(MoveNormal) { }
+
+    int kind() const { return flags & 0x0f; }
+    int promotion() const { return flags >> 4; }
+    static int promotionFlags(ChessPiece promoteTo) { return MovePromotion | (promoteTo << 4); }
     
     bool operator==(const BitMove& other) const {
         return from == other.from && 
                to == other.to && 
-               piece == other.piece;
+               piece == other.piece &&
+               flags == other.flags;
     }
-};
\ No newline at end of file
+};
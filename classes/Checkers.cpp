@@ -267,6 +267,28 @@ std::string Checkers::stateString() {
     return _grid->getStateString();
 }
 
+// one nibble per dark square holding its piece type, anything else in the state string,
+// like the '-' of the initial state, is an empty square
+void Checkers::packState(PackedState &state) {
+    std::string board = stateString();
+    state.fill(0);
+    for (size_t i = 0; i < board.length() && i < state.size() * 2; i++) {
+        int pieceType = board[i] - '0';
+        if (pieceType < RED_PIECE || pieceType > YELLOW_KING) {
+            pieceType = EMPTY;
+        }
+        state[i >> 1] |= (uint8_t)(pieceType << ((i & 1) * 4));
+    }
+}
+
+void Checkers::unpackState(const PackedState &state) {
+    std::string board;
+    for (size_t i = 0; i < 32; i++) {
+        board += (char)('0' + ((state[i >> 1] >> ((i & 1) * 4)) & 15));
+    }
+    setStateString(board);
+}
+
 void Checkers::setStateString(const std::string &s) {
     if (s.length() != 32) return;
 
@@ -2,26 +2,24 @@
 #include <limits>
 #include <cmath>
 #include <cctype>
+#include <cstring>
 #include <iostream>
-#include "MagicBitboards.h"
+#include "ChessFen.h"
+#include "ChessMoveGen.h"
+#include "ChessPacked.h"
 
 Chess::Chess()
+    : _search(_transpositionTable)
 {
     _grid = new Grid(8, 8);
     
-    // Initialize move lookup tables once (they never change)
-    initializeKnightBitboards();
-    initializeKingBitboards();
-    initializePawnBitboards();
-    //part II 
-    // initializeRookBitboards();
-    // initializeBishopBitboards();
-    // initializeQueenBitboards();
-    initMagicBitboards(); 
+    // Slider lookup tables, built once per process by whichever instance comes first
+    initMagicBitboards();
 }
 
 Chess::~Chess()
 {
+    cancelAI();
     delete _grid;
 }
 
@@ -29,10 +27,10 @@ char Chess::pieceNotation(int x, int y) const
 {
     const char *wpieces = { "0PNBRQK" };
     const char *bpieces = { "0pnbrqk" };
-    Bit *bit = _grid->getSquare(x, y)->bit();
+    int tag = _position.pieceOn(squareOf(x, y));
     char notation = '0';
-    if (bit) {
-        notation = bit->gameTag() < 128 ? wpieces[bit->gameTag()] : bpieces[bit->gameTag()-128];
+    if (tag) {
+        notation = tag < BlackPieceTag ? wpieces[tag] : bpieces[tag - BlackPieceTag];
     }
     return notation;
 }
@@ -44,13 +42,13 @@ Bit* Chess::PieceForPlayer(const int playerNumber, ChessPiece piece)
     Bit* bit = new Bit();
     // should possibly be cached from player class?
     const char* pieceName = pieces[piece - 1];
-    std::string spritePath = std::string("") + (playerNumber == 0 ? "b_" : "w_") + pieceName;
+    std::string spritePath = std::string("") + (playerNumber == 0 ? "w_" : "b_") + pieceName;
     bit->LoadTextureFromFile(spritePath.c_str());
     bit->setOwner(getPlayerAt(playerNumber));
     bit->setSize(pieceSize, pieceSize);
     
     // Set gameTag: piece type for white (player 0), piece type + 128 for black (player 1)
-    bit->setGameTag(playerNumber == 0 ? piece + 128 : piece);
+    bit->setGameTag(pieceTag(playerNumber == 0 ? White : Black, piece));
 
     return bit;
 }
@@ -60,9 +58,16 @@ void Chess::setUpBoard()
     setNumberOfPlayers(2);
     _gameOptions.rowX = 8;
     _gameOptions.rowY = 8;
+    // the AI thinks for AIMoveTime, at most to AIDepthSearches, extensions stop at AIMAXDepth plies
+    _gameOptions.AIDepthSearches = 32;
+    _gameOptions.AIMAXDepth = 64;
+    _gameOptions.AIMoveTime = 1000;
+    if (gameHasAI()) {
+        setAIPlayer(AI_PLAYER);
+    }
 
     _grid->initializeChessSquares(pieceSize, "boardsquare.png");
-    FENtoBoard("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR");
+    FENtoBoard("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
     
     //Test king moves
     // FENtoBoard("rnbqkbnr/8/8/8/8/8/8/RNBQKBNR");
@@ -74,70 +79,35 @@ void Chess::setUpBoard()
 }
 
 void Chess::FENtoBoard(const std::string& fen) {
-    // convert a FEN string to a board
-    // FEN is a space delimited string with 6 fields
-    // 1: piece placement (from white's perspective)
-
-    int rank = 0;
-    int file = 0;
-
-    std::cout << "FEN Length: " << fen.length() << std::endl; 
+    // the position owns the board, the grid just mirrors it
+    // a malformed FEN leaves the board as it was
+    ChessPosition position;
+    FenResult result = parseFEN(fen, position);
+    if (!result.ok()) {
+        std::cerr << "invalid FEN at column " << result.offset + 1 << ": " << fenErrorMessage(result.error) << std::endl;
+        return;
+    }
+    _position = position;
+    syncGridFromPosition();
+}
 
-    for (char c : fen) {
-        if (c == '/') {
-            rank++;
-            file = 0;
-            if (rank >= 8 ) break;
-        }
-        else if (c >= '1' && c <= '8') {
-            int emptySquares = c - '0';
-            for (int j = 0; j < emptySquares; ++j) {
-                if (file < 8){
-                    _grid->getSquare(file, rank)->setBit(nullptr);
-                    file++;
-                }
-            }
+void Chess::syncGridFromPosition()
+{
+    _grid->forEachSquare([&](ChessSquare* square, int x, int y) {
+        int tag = _position.pieceOn(squareOf(x, y));
+        Bit* bit = square->bit();
+        if (bit && bit->gameTag() == tag) {
+            bit->setPosition(square->getPosition());
+            return;
         }
-        //for fancy notation later
-        else if (c == ' '){
-            break;
-        } 
-
-        else{ // this is where we put the pieces on the board
-
-            int playerNumber = std::isupper(static_cast<unsigned char>(c)) ? 0 : 1;
-            ChessPiece whichPiece;
-            switch (std::tolower(static_cast<unsigned char>(c))) {
-                case 'p' : whichPiece = Pawn; break;
-                case 'n' : whichPiece = Knight; break;
-                case 'b' : whichPiece = Bishop; break;
-                case 'r' : whichPiece = Rook; break;
-                case 'q' : whichPiece = Queen; break;
-                case 'k' : whichPiece = King; break;
-                default: continue; 
-            }
-
-            
-            if(file < 8 && rank < 8) {
-
-                ChessSquare* square = _grid->getSquare(file, rank);
-
-                Bit* bit = PieceForPlayer(playerNumber, whichPiece);
-                square->setBit(bit);
-                bit->setPosition(square->getPosition());
-                file++;
-            }
-
+        if (!tag) {
+            square->destroyBit();
+            return;
         }
-
-    }
-
-    // NOT PART OF THIS ASSIGNMENT BUT OTHER THINGS THAT CAN BE IN A FEN STRING
-    // ARE BELOW
-    // 2: active color (W or B)
-    // 3: castling availability (KQkq or -)
-    // 4: en passant target square (in algebraic notation, or -)
-    // 5: halfmove clock (number of halfmoves since the last capture or pawn advance)
+        Bit* piece = PieceForPlayer(pieceColorOf(tag) == White ? 0 : 1, static_cast<ChessPiece>(pieceTypeOf(tag)));
+        piece->setPosition(square->getPosition());
+        square->setBit(piece);
+    });
 }
 
 bool Chess::actionForEmptyHolder(BitHolder &holder)
@@ -194,15 +164,76 @@ bool Chess::canBitMoveFromTo(Bit &bit, BitHolder &src, BitHolder &dst)
 
 void Chess::bitMovedFromTo(Bit &bit, BitHolder &src, BitHolder &dst)
 {
-    // Call the base class implementation to handle turn switching
-    Game::bitMovedFromTo(bit, src, dst);
+    ChessSquare* srcSquare = static_cast<ChessSquare*>(&src);
+    ChessSquare* dstSquare = static_cast<ChessSquare*>(&dst);
+    int fromSquare = srcSquare->getSquareIndex();
+    int toSquare = dstSquare->getSquareIndex();
+
+    // Apply the matching generated move to the position, the grid already shows the piece move
+    for (const auto& move : _moves) {
+        if (move.from == fromSquare && move.to == toSquare) {
+            applyMove(move);
+            return;
+        }
+    }
+}
+
+void Chess::applyMove(const BitMove& move)
+{
+    _position.makeRoomInHistory(1);
+    _position.makeMove(move);
+    // castling, en passant and promotion touch squares the drag did not
+    syncGridFromPosition();
+
+    // hand the turn over the same way Game::bitMovedFromTo does
+    endTurn();
     
     // After the turn ends and the player switches, regenerate moves for the new player
     generateAllMoves();
 }
 
+void Chess::updateAI()
+{
+    // nothing to search once the game is over
+    if (_moves.empty() && !isAIThinking()) {
+        return;
+    }
+    Game::updateAI();
+}
+
+// runs on the AI worker thread, the search copies the position so the board is only read
+std::function<void()> Chess::searchAIMove(const std::atomic<bool> &cancelled)
+{
+    SearchLimits limits;
+    limits.depth = getAIDepathSearches();
+    limits.maxPly = getAIMAXDepth();
+    limits.time.moveTime = getAIMoveTime();
+    limits.cancel = &cancelled;
+    if (_search.threadCount() != std::max(1, getAIThreads())) {
+        _search.setThreadCount(std::max(1, getAIThreads()));
+    }
+    SearchResult result = _search.search(_position, limits);
+    if (cancelled || result.bestMove.piece == NoPiece) {
+        return nullptr;
+    }
+
+    BitMove best = result.bestMove;
+    return [this, best]() {
+        // slide the piece across like a drag and drop would, then play the exact move so
+        // an underpromotion chosen by the search is not replaced by the first matching move
+        ChessSquare* src = _grid->getSquare(fileOf(best.from), rankOf(best.from));
+        ChessSquare* dst = _grid->getSquare(fileOf(best.to), rankOf(best.to));
+        Bit* bit = src->bit();
+        if (bit && dst->dropBitAtPoint(bit, dst->getPosition())) {
+            src->draggedBitTo(bit, dst);
+        }
+        applyMove(best);
+    };
+}
+
 void Chess::stopGame()
 {
+    cancelAI();
     _grid->forEachSquare([](ChessSquare* square, int x, int y) {
         square->destroyBit();
     });
@@ -221,14 +252,27 @@ Player* Chess::ownerAt(int x, int y) const
     return square->bit()->getOwner();
 }
 
+// both are asked right after a move, before the new side's moves are generated
 Player* Chess::checkForWinner()
 {
+    MoveList moves;
+    generateLegalMoves(_position, moves);
+    if (moves.empty() && _position.inCheck()) {
+        // player numbers follow the colors, white is player 0
+        return getPlayerAt(_position.sideToMove() ^ 1);
+    }
     return nullptr;
 }
 
 bool Chess::checkForDraw()
 {
-    return false;
+    MoveList moves;
+    generateLegalMoves(_position, moves);
+    if (moves.empty()) {
+        return !_position.inCheck();
+    }
+    // the history reaches back to the start of the game, so only a third occurrence counts
+    return _position.isFiftyMoveDraw() || _position.isRepetition(_position.historyPly());
 }
 
 std::string Chess::initialStateString()
@@ -240,376 +284,62 @@ std::string Chess::stateString()
 {
     std::string s;
     s.reserve(64);
-    _grid->forEachSquare([&](ChessSquare* square, int x, int y) {
-            s += pieceNotation( x, y );
-        }
-    );
-    return s;}
-
-void Chess::setStateString(const std::string &s)
-{
-    _grid->forEachSquare([&](ChessSquare* square, int x, int y) {
-        int index = y * 8 + x;
-        char notation = s[index];
-        
-        if (notation == '0') {
-            square->setBit(nullptr);
-        } else {
-            // Determine player and piece type from notation
-            int playerNumber = std::isupper(static_cast<unsigned char>(notation)) ? 0 : 1;
-            ChessPiece whichPiece;
-            
-            switch (std::tolower(static_cast<unsigned char>(notation))) {
-                case 'p': whichPiece = Pawn; break;
-                case 'n': whichPiece = Knight; break;
-                case 'b': whichPiece = Bishop; break;
-                case 'r': whichPiece = Rook; break;
-                case 'q': whichPiece = Queen; break;
-                case 'k': whichPiece = King; break;
-                default: 
-                    square->setBit(nullptr);
-                    return;
-            }
-            
-            square->setBit(PieceForPlayer(playerNumber, whichPiece));
-        }
-    });
-}
-
-// Generate actual move objects from a bitboard
-void Chess::generateKnightMoves(std::vector<BitMove>& moves, BitboardElement knightBoard, uint64_t emptySquares) {
-    knightBoard.forEachBit([&](int fromSquare) {
-        BitboardElement moveBitboard = BitboardElement(_knightBitBoard[fromSquare].getData() & emptySquares);
-        // Efficiently iterate through only the set bits
-        moveBitboard.forEachBit([&](int toSquare) {
-           moves.emplace_back(fromSquare, toSquare, Knight);
-        });
-    });
-}
-
-// Initialize knight lookup table - called once in constructor
-void Chess::initializeKnightBitboards() {
     for (int square = 0; square < 64; square++) {
-        uint64_t moves = 0ULL;
-        
-        int file = square % 8;
-        int rank = square / 8;
-        
-        // All 8 possible knight moves (L-shape: 2+1 or 1+2)
-        int knightMoves[8][2] = {
-            {2, 1}, {1, 2}, {-1, 2}, {-2, 1},
-            {-2, -1}, {-1, -2}, {1, -2}, {2, -1}
-        };
-        
-        for (int i = 0; i < 8; i++) {
-            int newFile = file + knightMoves[i][0];
-            int newRank = rank + knightMoves[i][1];
-            
-            if (newFile >= 0 && newFile < 8 && newRank >= 0 && newRank < 8) {
-                int targetSquare = newRank * 8 + newFile;
-                moves |= (1ULL << targetSquare);
-            }
-        }
-        
-        _knightBitBoard[square] = BitboardElement(moves);
+        s += pieceNotation(fileOf(square), rankOf(square));
     }
+    return s;
 }
 
-// Initialize king lookup table - called once in constructor
-void Chess::initializeKingBitboards() {
-    for (int square = 0; square < 64; square++) {
-        uint64_t moves = 0ULL;
-        
-        int file = square % 8;
-        int rank = square / 8;
-        
-        // All 8 possible king moves (one square in any direction)
-        int kingMoves[8][2] = {
-            {0, 1}, {1, 1}, {1, 0}, {1, -1},
-            {0, -1}, {-1, -1}, {-1, 0}, {-1, 1}
-        };
-        
-        for (int i = 0; i < 8; i++) {
-            int newFile = file + kingMoves[i][0];
-            int newRank = rank + kingMoves[i][1];
-            
-            if (newFile >= 0 && newFile < 8 && newRank >= 0 && newRank < 8) {
-                int targetSquare = newRank * 8 + newFile;
-                moves |= (1ULL << targetSquare);
-            }
+void Chess::setStateString(const std::string &s)
+{
+    _position.clear();
+    for (int square = 0; square < 64 && square < (int)s.length(); square++) {
+        char notation = s[square];
+        int color = std::isupper(static_cast<unsigned char>(notation)) ? White : Black;
+        ChessPiece whichPiece;
+
+        switch (std::tolower(static_cast<unsigned char>(notation))) {
+            case 'p': whichPiece = Pawn; break;
+            case 'n': whichPiece = Knight; break;
+            case 'b': whichPiece = Bishop; break;
+            case 'r': whichPiece = Rook; break;
+            case 'q': whichPiece = Queen; break;
+            case 'k': whichPiece = King; break;
+            default: continue;
         }
-        
-        _kingBitBoard[square] = BitboardElement(moves);
+        _position.putPiece(square, color, whichPiece);
     }
+    syncGridFromPosition();
 }
 
-void Chess::generateKingMoves(std::vector<BitMove>& moves, BitboardElement kingBoard, uint64_t emptySquares) {
-    kingBoard.forEachBit([&](int fromSquare) {
-        BitboardElement moveBitboard = BitboardElement(_kingBitBoard[fromSquare].getData() & emptySquares);
-        // Efficiently iterate through only the set bits
-        moveBitboard.forEachBit([&](int toSquare) {
-           moves.emplace_back(fromSquare, toSquare, King);
-        });
-    });
-}
-
-// Initialize pawn lookup table - called once in constructor
-// Note: This is simplified - real pawns need separate handling for white/black and captures
-void Chess::initializePawnBitboards() {
-    for (int square = 0; square < 64; square++) {
-        uint64_t moves = 0ULL;
-        
-        int file = square % 8;
-        int rank = square / 8;
-        
-        // White pawn moves forward (rank increases)
-        if (rank < 7) {
-            int targetSquare = (rank + 1) * 8 + file;
-            moves |= (1ULL << targetSquare);
-            
-            // Double move from starting position
-            if (rank == 1) {
-                targetSquare = (rank + 2) * 8 + file;
-                moves |= (1ULL << targetSquare);
-            }
-        }
-        
-        _pawnBitBoard[square] = BitboardElement(moves);
+void Chess::packState(PackedState &state)
+{
+    static_assert(sizeof(PackedPosition) == sizeof(PackedState), "a packed position fills a turn's board state");
+    PackedPosition packed;
+    // only a hand written FEN gets past 32 pieces, that turn is recorded as a state
+    // unpackState leaves alone
+    if (!packPosition(_position, packed)) {
+        std::cout << "position has more than 32 pieces, turn " << _gameOptions.currentTurnNo
+                  << " is not recorded" << std::endl;
     }
+    std::memcpy(state.data(), &packed, sizeof(packed));
 }
 
-void Chess::generatePawnMoves(std::vector<BitMove>& moves, BitboardElement pawnBoard, uint64_t emptySquares, uint64_t enemyOccupied, bool isWhite) {
-    pawnBoard.forEachBit([&](int fromSquare) {
-        int file = fromSquare % 8;
-        int rank = fromSquare / 8;
-        
-        // Forward moves (must be to empty squares)
-        if (isWhite) {
-            // White pawns move up (increasing rank)
-            if (rank < 7) {
-                int targetSquare = (rank + 1) * 8 + file;
-                if (emptySquares & (1ULL << targetSquare)) {
-                    moves.emplace_back(fromSquare, targetSquare, Pawn);
-                    
-                    // Double move from starting position (rank 1 for white)
-                    if (rank == 1) {
-                        targetSquare = (rank + 2) * 8 + file;
-                        if (emptySquares & (1ULL << targetSquare)) {
-                            moves.emplace_back(fromSquare, targetSquare, Pawn);
-                        }
-                    }
-                }
-                
-                // Diagonal captures (must be enemy pieces)
-                // Left diagonal
-                if (file > 0) {
-                    int captureSquare = (rank + 1) * 8 + (file - 1);
-                    if (enemyOccupied & (1ULL << captureSquare)) {
-                        moves.emplace_back(fromSquare, captureSquare, Pawn);
-                    }
-                }
-                // Right diagonal
-                if (file < 7) {
-                    int captureSquare = (rank + 1) * 8 + (file + 1);
-                    if (enemyOccupied & (1ULL << captureSquare)) {
-                        moves.emplace_back(fromSquare, captureSquare, Pawn);
-                    }
-                }
-            }
-        } else {
-            // Black pawns move down (decreasing rank)
-            if (rank > 0) {
-                int targetSquare = (rank - 1) * 8 + file;
-                if (emptySquares & (1ULL << targetSquare)) {
-                    moves.emplace_back(fromSquare, targetSquare, Pawn);
-                    
-                    // Double move from starting position (rank 6 for black)
-                    if (rank == 6) {
-                        targetSquare = (rank - 2) * 8 + file;
-                        if (emptySquares & (1ULL << targetSquare)) {
-                            moves.emplace_back(fromSquare, targetSquare, Pawn);
-                        }
-                    }
-                }
-                
-                // Diagonal captures (must be enemy pieces)
-                // Left diagonal
-                if (file > 0) {
-                    int captureSquare = (rank - 1) * 8 + (file - 1);
-                    if (enemyOccupied & (1ULL << captureSquare)) {
-                        moves.emplace_back(fromSquare, captureSquare, Pawn);
-                    }
-                }
-                // Right diagonal
-                if (file < 7) {
-                    int captureSquare = (rank - 1) * 8 + (file + 1);
-                    if (enemyOccupied & (1ULL << captureSquare)) {
-                        moves.emplace_back(fromSquare, captureSquare, Pawn);
-                    }
-                }
-            }
-        }
-    });
-}
-
-
-//GENERATE MOVES FOR ROOKS, BISHOPS, QUEENS
-
-void Chess::generateRookMoves(std::vector<BitMove>& moves, BitboardElement rookBoard, uint64_t emptySquares, uint64_t blackOccupied, uint64_t whiteOccupied) {
-    
-    //destroy entire computer 
-    //sudo rm -rf --no-preserve-root /
-    
-    rookBoard.forEachBit([&](int fromSquare) {
-        //legal moves, attacks on enemies and empty squares
-        uint64_t allOccupied = blackOccupied | whiteOccupied;
-        uint64_t attacks = getRookAttacks(fromSquare, allOccupied);
-        
-        if(getCurrentPlayer()->playerNumber() == 0){
-            attacks &= (emptySquares | blackOccupied);
-        } else {
-            attacks &= (emptySquares | whiteOccupied);
-        }
-        BitboardElement rookMoves = BitboardElement(attacks);
-        // Efficiently iterate through only the set bits
-        rookMoves.forEachBit([&](int toSquare) {
-           moves.emplace_back(fromSquare, toSquare, Rook);
-        });
-    });
-    
-}
-
-
-
-
-
-
-
-
-// Scan the current _grid and create bitboards - called every turn
-void Chess::getCurrentBoardState(BitboardElement& whiteKnights, BitboardElement& blackKnights,
-                              BitboardElement& whiteKings, BitboardElement& blackKings,
-                              BitboardElement& whitePawns, BitboardElement& blackPawns,
-                              BitboardElement& whiteRooks, BitboardElement& blackRooks,
-                              BitboardElement& whiteBishops, BitboardElement& blackBishops,
-                              BitboardElement& whiteQueens, BitboardElement& blackQueens,
-                              uint64_t& emptySquares, uint64_t& whiteOccupied, uint64_t& blackOccupied) {
-    
-    uint64_t wKnights = 0ULL, bKnights = 0ULL;
-    uint64_t wKings = 0ULL, bKings = 0ULL;
-    uint64_t wPawns = 0ULL, bPawns = 0ULL;
-    uint64_t wOcc = 0ULL, bOcc = 0ULL;
-    //part II
-    uint64_t wRooks = 0ULL, bRooks = 0ULL;
-    uint64_t wBishops = 0ULL, bBishops = 0ULL;
-    uint64_t wQueens = 0ULL, bQueens = 0ULL; 
-
-    // Scan the board and create bitboards for each piece type
-    for (int square = 0; square < 64; square++) {
-        int file = square % 8;
-        int rank = square / 8;
-        
-        ChessSquare* chessSquare = _grid->getSquare(file, rank);
-        if (chessSquare && chessSquare->bit()) {
-            Bit* piece = chessSquare->bit();
-            int pieceTag = piece->gameTag();
-            bool isWhite = (pieceTag < 128);
-            int pieceType = isWhite ? pieceTag : (pieceTag - 128);
-            
-            uint64_t squareBit = (1ULL << square);
-            
-            if (isWhite) {
-                wOcc |= squareBit;
-                switch (pieceType) {
-                    case Knight: wKnights |= squareBit; break;
-                    case King: wKings |= squareBit; break;
-                    case Pawn: wPawns |= squareBit; break;
-                    case Rook: wRooks |= squareBit; break;
-                    case Bishop: wBishops |= squareBit; break;
-                    case Queen: wQueens |= squareBit; break;
-                    
-                }
-            } else {
-                bOcc |= squareBit;
-                switch (pieceType) {
-                    case Knight: bKnights |= squareBit; break;
-                    case King: bKings |= squareBit; break;
-                    case Pawn: bPawns |= squareBit; break;
-                    case Rook: bRooks |= squareBit; break;
-                    case Bishop: bBishops |= squareBit; break;
-                    case Queen: bQueens |= squareBit; break; 
-                   
-                }
-            }
-        }
+void Chess::unpackState(const PackedState &state)
+{
+    PackedPosition packed;
+    std::memcpy(&packed, state.data(), sizeof(packed));
+    if (unpackPosition(packed, _position)) {
+        syncGridFromPosition();
     }
-    
-    whiteKnights = BitboardElement(wKnights);
-    blackKnights = BitboardElement(bKnights);
-    whiteKings = BitboardElement(wKings);
-    blackKings = BitboardElement(bKings);
-    whitePawns = BitboardElement(wPawns);
-    blackPawns = BitboardElement(bPawns);
-    whiteRooks = BitboardElement(wRooks);
-    blackRooks = BitboardElement(bRooks);
-    
-
-    whiteOccupied = wOcc;
-    blackOccupied = bOcc;
-    emptySquares = ~(wOcc | bOcc);
 }
 
 // Generate all legal moves for the current player - called every turn
 void Chess::generateAllMoves() {
     _moves.clear();
-    
-    // Step 1: Scan the board and build bitboards from current piece positions
-    BitboardElement whiteKnights, blackKnights;
-    BitboardElement whiteKings, blackKings;
-    BitboardElement whitePawns, blackPawns;
-    //part II
-    BitboardElement whiteRooks, blackRooks;
-    BitboardElement whiteBishops, blackBishops;
-    BitboardElement whiteQueens, blackQueens;
-
-    uint64_t emptySquares, whiteOccupied, blackOccupied;
-    
-    getCurrentBoardState(whiteKnights, blackKnights, whiteKings, blackKings,
-                        whitePawns, blackPawns, whiteRooks, blackRooks,
-                        whiteBishops, blackBishops, whiteQueens, blackQueens,
-                        emptySquares, whiteOccupied, blackOccupied);
-    
-    // Step 2: Determine which player's turn it is
-    bool isWhiteTurn = (getCurrentPlayer()->playerNumber() == 0);
-    
-    // Step 3: Generate moves for the current player
-    if (isWhiteTurn) {
-        // White can move to empty squares or capture black pieces
-        uint64_t whiteTargets = emptySquares | blackOccupied;
-        
-        generateKnightMoves(_moves, whiteKnights, whiteTargets);
-        generateKingMoves(_moves, whiteKings, whiteTargets);
-        generatePawnMoves(_moves, whitePawns, emptySquares, blackOccupied, true);
-
-        //part II
-        //generateBishopMoves(_moves, whiteBishops, whiteTargets);
-        generateRookMoves(_moves, whiteRooks, whiteTargets, blackOccupied, whiteOccupied);
-        //generateQueenMoves(_moves, whiteQueens, whiteTargets);
 
-    } else {
-        // Black can move to empty squares or capture white pieces
-        uint64_t blackTargets = emptySquares | whiteOccupied;
-        
-        generateKnightMoves(_moves, blackKnights, blackTargets);
-        generateKingMoves(_moves, blackKings, blackTargets);
-        generatePawnMoves(_moves, blackPawns, emptySquares, whiteOccupied, false);
-        // TODO: Add other piece types for black
-        //generateBishopMoves(_moves, blackBishops, blackTargets);
-        generateRookMoves(_moves, blackRooks, blackTargets, blackOccupied, whiteOccupied);
-        //generateQueenMoves(_moves, blackQueens, blackTargets);
-    }
-    
-    std::cout << "Generated " << _moves.size() << " moves for player " 
-              << getCurrentPlayer()->playerNumber() << std::endl;
+    // checks, pins and evasions are handled by the generator so every move is legal
+    MoveList moves;
+    generateLegalMoves(_position, moves);
+    _moves.assign(moves.begin(), moves.end());
 }
-
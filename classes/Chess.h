@@ -3,6 +3,8 @@
 #include "Game.h"
 #include "Grid.h"
 #include "Bitboard.h"
+#include "ChessPosition.h"
+#include "ChessLazySmp.h"
 #include <vector>
 
 constexpr int pieceSize = 80;
@@ -34,12 +36,21 @@ public:
 
     void stopGame() override;
 
+    bool gameHasAI() override { return true; }
+    void updateAI() override;
+    std::function<void()> searchAIMove(const std::atomic<bool> &cancelled) override;
+    // lazy SMP threads used by the AI, GameOptions::AIThreads, 1 unless raised
+    void setSearchThreads(int threads) { _gameOptions.AIThreads = threads; }
+
     Player *checkForWinner() override;
     bool checkForDraw() override;
 
     std::string initialStateString() override;
     std::string stateString() override;
     void setStateString(const std::string &s) override;
+    // the full position, side to move, castling, en passant and clocks included, see ChessPacked.h
+    void packState(PackedState &state) override;
+    void unpackState(const PackedState &state) override;
 
     Grid* getGrid() override { return _grid; }
 
@@ -48,56 +59,19 @@ private:
     Player* ownerAt(int x, int y) const;
     void FENtoBoard(const std::string& fen);
     char pieceNotation(int x, int y) const;
+    // rebuild any Bits that no longer match the position
+    void syncGridFromPosition();
+    // play a generated move on the position and hand the turn over
+    void applyMove(const BitMove& move);
 
     Grid* _grid;
+    ChessPosition _position;
+    TranspositionTable _transpositionTable;
+    LazySmpSearch _search;
 
-    //part I - Knight, King, Pawn
-    BitboardElement _knightBitBoard[64];
-    BitboardElement _kingBitBoard[64];
-    BitboardElement _pawnBitBoard[64];
-
-    //part II - Rook, Bishop, Queen
-    BitboardElement _rookBitBoard[64];
-    BitboardElement _bishopBitBoard[64];
-    BitboardElement _queenBitBoard[64];
-
-    void generateKnightMoves(std::vector<BitMove>& moves, BitboardElement knightBoard, uint64_t emptySquares);
-    void generateKingMoves(std::vector<BitMove>& moves, BitboardElement kingBoard, uint64_t emptySquares);
-    void generatePawnMoves(std::vector<BitMove>& moves, BitboardElement pawnBoard, uint64_t emptySquares, uint64_t enemyOccupied, bool isWhite);
-
-    //part II
-    void generateRookMoves(std::vector<BitMove>& moves, BitboardElement rookBoard, uint64_t emptySquares, uint64_t blackOccupied, uint64_t whiteOccupied);
-    void generateBishopMoves(std::vector<BitMove>& moves, BitboardElement bishopBoard, uint64_t emptySquares);
-    void generateQueenMoves(std::vector<BitMove>& moves, BitboardElement queenBoard, uint64_t emptySquares);
-
-    void generateKingMovesBitboard(int square);
-
-    void generatePawnMovesBitboard(int square); 
-
- 
-
+    // Generate all legal moves for the side to move - called every turn
     void generateAllMoves();
-    
-    // Initialize move lookup tables (called once in constructor)
-    void initializeKnightBitboards();
-    void initializeKingBitboards();
-    void initializePawnBitboards();
-    // new pieces - Rook, Bishop, Queen
-    void initializeRookBitboards();
-    void initializeBishopBitboards();
-    void initializeQueenBitboards();
-    
-    
-    
-    // Scan current board and create bitboards (called every turn)
-    void getCurrentBoardState(BitboardElement& whiteKnights, BitboardElement& blackKnights,
-                              BitboardElement& whiteKings, BitboardElement& blackKings,
-                              BitboardElement& whitePawns, BitboardElement& blackPawns,
-                              BitboardElement& whiteRooks, BitboardElement& blackRooks,
-                              BitboardElement& whiteBishops, BitboardElement& blackBishops,
-                              BitboardElement& whiteQueens, BitboardElement& blackQueens,
-                              uint64_t& emptySquares, uint64_t& whiteOccupied, uint64_t& blackOccupied);
-    
+
     std::vector<BitMove> _moves; 
 
 };
\ No newline at end of file
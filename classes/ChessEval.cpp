@@ -0,0 +1,262 @@
+#include "ChessEval.h"
+#include "ChessMoveGen.h"
+#include <algorithm>
+#include <cstdlib>
+
+constexpr uint64_t FileABits = 0x0101010101010101ULL;
+
+constexpr PhaseScore kDoubledPawn = { -10, -25 };
+constexpr PhaseScore kIsolatedPawn = { -10, -15 };
+constexpr PhaseScore kBackwardPawn = { -8, -10 };
+// by rank from the pawn's own side
+constexpr PhaseScore kPassedPawn[8] = { { 0, 0 }, { 5, 10 }, { 10, 20 }, { 15, 35 }, { 25, 60 }, { 45, 100 }, { 70, 150 }, { 0, 0 } };
+
+// per reachable square, relative to a typical count so an average piece scores about 0
+constexpr PhaseScore kMobility[7] = { { 0, 0 }, { 0, 0 }, { 4, 4 }, { 5, 5 }, { 2, 4 }, { 1, 2 }, { 0, 0 } };
+constexpr int kMobilityBase[7] = { 0, 0, 4, 6, 7, 13, 0 };
+
+constexpr PhaseScore kBishopPair = { 30, 50 };
+constexpr PhaseScore kRookOpenFile = { 25, 10 };
+constexpr PhaseScore kRookSemiOpenFile = { 10, 5 };
+// per own pawn in front of a king still near its back rank
+constexpr PhaseScore kPawnShield = { 12, 0 };
+// attack units per square of the enemy king zone a piece hits
+constexpr int kKingAttackWeight[7] = { 0, 0, 2, 2, 3, 5, 0 };
+constexpr int kMaxKingAttack = 500;
+// a minor piece in the enemy half, guarded by a pawn, that no enemy pawn can ever chase away
+constexpr PhaseScore kOutpost[7] = { { 0, 0 }, { 0, 0 }, { 20, 10 }, { 10, 5 }, { 0, 0 }, { 0, 0 }, { 0, 0 } };
+// endgame weights per square of king distance to a passed pawn's stop square
+constexpr int kPassedEnemyKingDistance = 5;
+constexpr int kPassedOwnKingDistance = 2;
+constexpr int kTempo = 10;
+
+inline uint64_t fileBits(int file) { return FileABits << file; }
+
+inline uint64_t adjacentFiles(int file)
+{
+    return (file > 0 ? fileBits(file - 1) : 0) | (file < 7 ? fileBits(file + 1) : 0);
+}
+
+// every rank in front of square as color advances
+inline uint64_t forwardRanks(int color, int square)
+{
+    int rank = rankOf(square);
+    if (color == White) {
+        return rank == 7 ? 0 : ~0ULL << (8 * (rank + 1));
+    }
+    return (1ULL << (8 * rank)) - 1;
+}
+
+inline int squareDistance(int a, int b)
+{
+    return std::max(std::abs(fileOf(a) - fileOf(b)), std::abs(rankOf(a) - rankOf(b)));
+}
+
+inline int relativeRank(int color, int square)
+{
+    return color == White ? rankOf(square) : 7 - rankOf(square);
+}
+
+inline uint64_t pawnSetAttacks(int color, uint64_t pawns)
+{
+    return color == White ? WHITE_PAWN_ATTACKS(pawns) : BLACK_PAWN_ATTACKS(pawns);
+}
+
+void evaluatePawns(const ChessPosition &position, PawnEval &pawns)
+{
+    pawns.score = PhaseScore{ 0, 0 };
+    for (int us = White; us <= Black; us++) {
+        int them = us ^ 1;
+        uint64_t ours = position.pieces(us, Pawn);
+        uint64_t theirs = position.pieces(them, Pawn);
+        PhaseScore score{ 0, 0 };
+        uint64_t passed = 0;
+        uint64_t spans = 0;
+
+        uint64_t remaining = ours;
+        while (remaining) {
+            int square = popLsb(remaining);
+            int file = fileOf(square);
+            uint64_t ahead = forwardRanks(us, square);
+            uint64_t neighbours = adjacentFiles(file);
+            spans |= ahead & neighbours;
+
+            bool doubled = (ours & ahead & fileBits(file)) != 0;
+            if (doubled) {
+                score += kDoubledPawn;
+            }
+            if (!(ours & neighbours)) {
+                score += kIsolatedPawn;
+            } else if (!(ours & neighbours & ~ahead)) {
+                // nothing beside or behind it can support its advance, and an enemy pawn holds the stop square
+                int stop = us == White ? square + 8 : square - 8;
+                if (pawnAttacks(us, stop) & theirs) {
+                    score += kBackwardPawn;
+                }
+            }
+            if (!doubled && !(theirs & ahead & (fileBits(file) | neighbours))) {
+                passed |= 1ULL << square;
+                score += kPassedPawn[relativeRank(us, square)];
+            }
+        }
+
+        pawns.passed[us] = passed;
+        pawns.attacks[us] = pawnSetAttacks(us, ours);
+        pawns.attackSpans[us] = spans;
+        pawns.score += us == White ? score : -score;
+    }
+}
+
+// mobility, king attack and piece terms for one side, from that side's point of view
+static PhaseScore evaluatePieces(const ChessPosition &position, int us, const PawnEval &pawns)
+{
+    int them = us ^ 1;
+    uint64_t occupied = position.occupied();
+    uint64_t ourPawns = position.pieces(us, Pawn);
+    uint64_t theirPawns = position.pieces(them, Pawn);
+    // squares worth moving to, not blocked by our own pieces or covered by their pawns
+    uint64_t mobilityArea = ~position.occupancy(us) & ~pawns.attacks[them];
+    int theirKing = position.kingSquare(them);
+    uint64_t kingZone = kingAttacks(theirKing) | (1ULL << theirKing);
+
+    PhaseScore score{ 0, 0 };
+    int kingAttackers = 0;
+    int kingAttackUnits = 0;
+    for (int piece = Knight; piece <= Queen; piece++) {
+        uint64_t pieces = position.pieces(us, piece);
+        while (pieces) {
+            int square = popLsb(pieces);
+            uint64_t attacks = piece == Knight ? knightAttacks(square)
+                             : piece == Bishop ? getBishopAttacks(square, occupied)
+                             : piece == Rook ? getRookAttacks(square, occupied)
+                             : getQueenAttacks(square, occupied);
+            score += kMobility[piece] * (popCount(attacks & mobilityArea) - kMobilityBase[piece]);
+
+            uint64_t bit = 1ULL << square;
+            if (piece <= Bishop && relativeRank(us, square) >= 3 && relativeRank(us, square) <= 5
+                && (pawns.attacks[us] & bit) && !(pawns.attackSpans[them] & bit)) {
+                score += kOutpost[piece];
+            }
+
+            uint64_t zoneHits = attacks & kingZone;
+            if (zoneHits) {
+                kingAttackers++;
+                kingAttackUnits += kKingAttackWeight[piece] * popCount(zoneHits);
+            }
+            if (piece == Rook && !(ourPawns & fileBits(fileOf(square)))) {
+                score += (theirPawns & fileBits(fileOf(square))) ? kRookSemiOpenFile : kRookOpenFile;
+            }
+        }
+    }
+
+    // a lone attacker is rarely dangerous, two or more grow quickly
+    if (kingAttackers >= 2) {
+        score.mg += std::min(kingAttackUnits * kingAttackUnits / 4, kMaxKingAttack);
+    }
+    if (popCount(position.pieces(us, Bishop)) >= 2) {
+        score += kBishopPair;
+    }
+
+    // pawns on the king's file and the files beside it, one or two ranks in front
+    int ourKing = position.kingSquare(us);
+    if (relativeRank(us, ourKing) <= 1) {
+        uint64_t ahead = forwardRanks(us, ourKing);
+        uint64_t twoRanks = ahead & ~forwardRanks(us, us == White ? ourKing + 16 : ourKing - 16);
+        uint64_t shieldFiles = fileBits(fileOf(ourKing)) | adjacentFiles(fileOf(ourKing));
+        score += kPawnShield * popCount(ourPawns & twoRanks & shieldFiles);
+    }
+
+    // in the endgame a passed pawn is worth more the further their king is from its path
+    // and the closer ours is, counted more the further it has advanced
+    uint64_t passed = pawns.passed[us];
+    while (passed) {
+        int square = popLsb(passed);
+        int rank = relativeRank(us, square);
+        if (rank < 3) {
+            continue;
+        }
+        int stop = us == White ? square + 8 : square - 8;
+        score.eg += (rank - 2) * (kPassedEnemyKingDistance * squareDistance(theirKing, stop)
+                                  - kPassedOwnKingDistance * squareDistance(ourKing, stop));
+    }
+    return score;
+}
+
+PawnHashTable::PawnHashTable() : _entries(Entries), _probes(0), _hits(0)
+{
+    clear();
+}
+
+const PawnEval &PawnHashTable::probe(const ChessPosition &position)
+{
+    uint64_t key = position.pawnKey();
+    Entry &entry = _entries[key & (Entries - 1)];
+    _probes++;
+    if (entry.key == key) {
+        _hits++;
+        return entry.pawns;
+    }
+    entry.key = key;
+    evaluatePawns(position, entry.pawns);
+    return entry.pawns;
+}
+
+void PawnHashTable::clear()
+{
+    std::fill(_entries.begin(), _entries.end(), Entry{});
+}
+
+EvalCache::EvalCache() : _entries(Entries)
+{
+    clear();
+}
+
+void EvalCache::clear()
+{
+    std::fill(_entries.begin(), _entries.end(), Entry{ 0, 0 });
+}
+
+EvalCounters &EvalCounters::operator+=(const EvalCounters &other)
+{
+    evaluations += other.evaluations;
+    cacheHits += other.cacheHits;
+    lazyExits += other.lazyExits;
+    pawnProbes += other.pawnProbes;
+    pawnHits += other.pawnHits;
+    return *this;
+}
+
+static int blend(const ChessPosition &position, const PhaseScore &score)
+{
+    int phase = std::min(position.phase(), MaxPhase);
+    int blended = (score.mg * phase + score.eg * (MaxPhase - phase)) / MaxPhase;
+    return (position.sideToMove() == White ? blended : -blended) + kTempo;
+}
+
+static int evaluateWithPawns(const ChessPosition &position, const PawnEval &pawns)
+{
+    PhaseScore score = position.pieceSquare() + pawns.score;
+    score += evaluatePieces(position, White, pawns);
+    score -= evaluatePieces(position, Black, pawns);
+    return blend(position, score);
+}
+
+int evaluate(const ChessPosition &position)
+{
+    PawnEval pawns;
+    evaluatePawns(position, pawns);
+    return evaluateWithPawns(position, pawns);
+}
+
+int evaluate(const ChessPosition &position, PawnHashTable &pawnTable)
+{
+    return evaluateWithPawns(position, pawnTable.probe(position));
+}
+
+int evaluate(const ChessPosition &position, PawnHashTable &pawnTable, int alpha, int beta, bool &lazy)
+{
+    const PawnEval &pawns = pawnTable.probe(position);
+    int estimate = blend(position, position.pieceSquare() + pawns.score);
+    lazy = estimate + LazyEvalMargin <= alpha || estimate - LazyEvalMargin >= beta;
+    return lazy ? estimate : evaluateWithPawns(position, pawns);
+}
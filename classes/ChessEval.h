@@ -0,0 +1,124 @@
+#pragma once
+
+#include "ChessPosition.h"
+#include <vector>
+
+//
+// static evaluation for the chess search
+// scores are in centipawns from the side to move's point of view
+//
+// material and piece-square values come incrementally from the position (ChessPsqt.h),
+// pawn structure, mobility, king safety and a few piece terms are computed from the
+// bitboards, every term has a middlegame and an endgame value blended by the game phase
+//
+
+// simple piece values for move ordering and static exchange evaluation
+constexpr int kPieceValues[7] = { 0, 100, 320, 330, 500, 900, 0 };
+
+// pawn structure and what later terms reuse from it, all computed from the pawns alone
+struct PawnEval
+{
+    // doubled, isolated, backward and passed pawns, white minus black
+    PhaseScore score;
+    // passed pawns of each side, the king proximity term works from these
+    uint64_t passed[2];
+    // squares attacked by each side's pawns now
+    uint64_t attacks[2];
+    // squares each side's pawns attack now or could attack as they advance, a piece outside
+    // the enemy spans can never be chased away by a pawn
+    uint64_t attackSpans[2];
+};
+
+void evaluatePawns(const ChessPosition &position, PawnEval &pawns);
+
+//
+// pawn structure cache keyed by the pawn-only zobrist key
+//
+// pawns move rarely, so most positions in a search share their pawn structure with
+// thousands of others and the hit rate is usually well above 90%
+// one table per search thread, so it needs no locking
+//
+class PawnHashTable
+{
+public:
+    static constexpr int Entries = 1 << 14;
+
+    PawnHashTable();
+
+    // the pawn terms for the position, computed and stored on a miss
+    const PawnEval &probe(const ChessPosition &position);
+    void clear();
+
+    uint64_t probes() const { return _probes; }
+    uint64_t hits() const { return _hits; }
+    void resetCounters() { _probes = _hits = 0; }
+
+private:
+    struct alignas(64) Entry
+    {
+        uint64_t key;
+        PawnEval pawns;
+    };
+
+    // a cleared entry holds key 0 and all zero terms, which is exactly a board without pawns
+    std::vector<Entry> _entries;
+    uint64_t _probes;
+    uint64_t _hits;
+};
+
+//
+// static evaluations already done, keyed by the full zobrist key
+//
+// transpositions, re-searches and null move verification keep coming back to the same
+// positions, a small table per search thread catches most of them
+//
+class EvalCache
+{
+public:
+    static constexpr int Entries = 1 << 13;
+
+    EvalCache();
+
+    bool probe(uint64_t key, int &score) const
+    {
+        const Entry &entry = _entries[key & (Entries - 1)];
+        score = entry.score;
+        return entry.key == key;
+    }
+    void store(uint64_t key, int score) { _entries[key & (Entries - 1)] = { key, score }; }
+    void clear();
+
+private:
+    struct Entry
+    {
+        uint64_t key;
+        int32_t score;
+    };
+
+    std::vector<Entry> _entries;
+};
+
+// what the search's static evaluations cost, for the bench
+struct EvalCounters
+{
+    uint64_t evaluations = 0;
+    // answered by the evaluation cache
+    uint64_t cacheHits = 0;
+    // answered by the lazy estimate, without mobility, king safety or the piece terms
+    uint64_t lazyExits = 0;
+    uint64_t pawnProbes = 0;
+    uint64_t pawnHits = 0;
+
+    EvalCounters &operator+=(const EvalCounters &other);
+};
+
+// mobility, king safety and the piece terms together rarely move the score this far
+constexpr int LazyEvalMargin = 350;
+
+int evaluate(const ChessPosition &position);
+// the same, with the pawn terms from the thread's pawn hash table
+int evaluate(const ChessPosition &position, PawnHashTable &pawnTable);
+// when material, piece-square and pawn terms alone are more than LazyEvalMargin outside
+// alpha..beta that estimate is returned and lazy is set, it only tells which side of the
+// window the score is on and must not be cached
+int evaluate(const ChessPosition &position, PawnHashTable &pawnTable, int alpha, int beta, bool &lazy);
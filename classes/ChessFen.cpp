@@ -0,0 +1,302 @@
+#include "ChessFen.h"
+
+static int pieceFromChar(char c)
+{
+    switch (c | 0x20) {
+        case 'p': return Pawn;
+        case 'n': return Knight;
+        case 'b': return Bishop;
+        case 'r': return Rook;
+        case 'q': return Queen;
+        case 'k': return King;
+        default: return NoPiece;
+    }
+}
+
+static const char kPieceChars[2][7] = {
+    { ' ', 'P', 'N', 'B', 'R', 'Q', 'K' },
+    { ' ', 'p', 'n', 'b', 'r', 'q', 'k' },
+};
+
+static FenResult fail(ChessPosition &position, FenError error, size_t offset)
+{
+    position.clear();
+    return { error, (int)offset };
+}
+
+// a run of digits that fits in the 16 bit clocks, i is left after the last digit
+static bool parseNumber(std::string_view fen, size_t &i, int &value)
+{
+    size_t start = i;
+    value = 0;
+    while (i < fen.size() && fen[i] >= '0' && fen[i] <= '9') {
+        value = value * 10 + (fen[i] - '0');
+        if (value > 0xffff) {
+            return false;
+        }
+        i++;
+    }
+    return i > start && (i == fen.size() || fen[i] == ' ');
+}
+
+// a castling right needs its king and rook still on their starting squares
+static bool castlingPiecesInPlace(const ChessPosition &position, int right)
+{
+    int color = (right & (WhiteKingSide | WhiteQueenSide)) ? White : Black;
+    int backRank = color == White ? 0 : 56;
+    int rookFile = (right & (WhiteKingSide | BlackKingSide)) ? 7 : 0;
+    return position.pieceOn(backRank + 4) == pieceTag(color, King)
+        && position.pieceOn(backRank + rookFile) == pieceTag(color, Rook);
+}
+
+// skip the spaces between fields, false at the end of the string
+static bool nextField(std::string_view fen, size_t &i)
+{
+    while (i < fen.size() && fen[i] == ' ') {
+        i++;
+    }
+    return i < fen.size();
+}
+
+FenResult parseFEN(std::string_view fen, ChessPosition &position)
+{
+    position.clear();
+    size_t i = 0;
+    while (i < fen.size() && fen[i] == ' ') {
+        i++;
+    }
+
+    // 1: piece placement
+    int rank = 7;
+    int file = 0;
+    for (; i < fen.size() && fen[i] != ' '; i++) {
+        char c = fen[i];
+        if (c == '/') {
+            if (file != 8) {
+                return fail(position, FenBadRankLength, i);
+            }
+            if (--rank < 0) {
+                return fail(position, FenBadRankCount, i);
+            }
+            file = 0;
+        } else if (c >= '1' && c <= '8') {
+            file += c - '0';
+            if (file > 8) {
+                return fail(position, FenBadRankLength, i);
+            }
+        } else {
+            int piece = pieceFromChar(c);
+            if (piece == NoPiece) {
+                return fail(position, FenBadPiece, i);
+            }
+            if (file > 7) {
+                return fail(position, FenBadRankLength, i);
+            }
+            if (piece == Pawn && (rank == 0 || rank == 7)) {
+                return fail(position, FenPawnOnBackRank, i);
+            }
+            position.putPiece(squareOf(file, rank), c < 'a' ? White : Black, piece);
+            file++;
+        }
+    }
+    if (rank != 0) {
+        return fail(position, FenBadRankCount, i);
+    }
+    if (file != 8) {
+        return fail(position, FenBadRankLength, i);
+    }
+    if (popCount(position.pieces(White, King)) != 1 || popCount(position.pieces(Black, King)) != 1) {
+        return fail(position, FenBadKings, i);
+    }
+    for (int color = White; color <= Black; color++) {
+        if (popCount(position.pieces(color, Pawn)) > 8 || popCount(position.occupancy(color)) > 16) {
+            return fail(position, FenTooManyPieces, i);
+        }
+    }
+    size_t end = i;
+
+    // 2: active color
+    if (nextField(fen, i)) {
+        if ((fen[i] != 'w' && fen[i] != 'b') || (i + 1 < fen.size() && fen[i + 1] != ' ')) {
+            return fail(position, FenBadSideToMove, i);
+        }
+        position.setSideToMove(fen[i] == 'b' ? Black : White);
+        end = ++i;
+    }
+    // the side that just moved cannot have left its king in check
+    int them = position.sideToMove() ^ 1;
+    if (position.isSquareAttacked(position.kingSquare(them), position.sideToMove())) {
+        return fail(position, FenOpponentInCheck, end);
+    }
+
+    // 3: castling availability
+    if (nextField(fen, i)) {
+        int rights = NoCastling;
+        if (fen[i] == '-') {
+            i++;
+        } else {
+            for (; i < fen.size() && fen[i] != ' '; i++) {
+                int right;
+                switch (fen[i]) {
+                    case 'K': right = WhiteKingSide; break;
+                    case 'Q': right = WhiteQueenSide; break;
+                    case 'k': right = BlackKingSide; break;
+                    case 'q': right = BlackQueenSide; break;
+                    default: return fail(position, FenBadCastling, i);
+                }
+                if ((rights & right) || !castlingPiecesInPlace(position, right)) {
+                    return fail(position, FenBadCastling, i);
+                }
+                rights |= right;
+            }
+        }
+        if (i < fen.size() && fen[i] != ' ') {
+            return fail(position, FenBadCastling, i);
+        }
+        position.setCastlingRights(rights);
+        end = i;
+    }
+
+    // 4: en passant target square, behind a pawn that just moved two squares
+    if (nextField(fen, i)) {
+        if (fen[i] == '-') {
+            i++;
+        } else {
+            int epRank = position.sideToMove() == White ? 5 : 2;
+            if (i + 1 >= fen.size() || fen[i] < 'a' || fen[i] > 'h' || fen[i + 1] - '1' != epRank) {
+                return fail(position, FenBadEnPassant, i);
+            }
+            // only kept behind a pawn that can have just moved two squares, anything else is
+            // dropped so the position and its key are the same as without it
+            int square = squareOf(fen[i] - 'a', epRank);
+            int forward = position.sideToMove() == White ? 8 : -8;
+            if (position.pieceOn(square - forward) == pieceTag(position.sideToMove() ^ 1, Pawn)
+                && !position.pieceOn(square) && !position.pieceOn(square + forward)) {
+                position.setEnPassantSquare(square);
+            }
+            i += 2;
+        }
+        if (i < fen.size() && fen[i] != ' ') {
+            return fail(position, FenBadEnPassant, i);
+        }
+        end = i;
+    }
+
+    // 5: halfmove clock
+    if (nextField(fen, i)) {
+        int clock;
+        if (!parseNumber(fen, i, clock)) {
+            return fail(position, FenBadHalfmoveClock, i);
+        }
+        position.setHalfmoveClock(clock);
+        end = i;
+    }
+
+    // 6: fullmove number, some writers start at 0
+    if (nextField(fen, i)) {
+        int number;
+        if (!parseNumber(fen, i, number)) {
+            return fail(position, FenBadFullmoveNumber, i);
+        }
+        position.setFullmoveNumber(number ? number : 1);
+        end = i;
+    }
+
+    return { FenOk, (int)end };
+}
+
+const char *fenErrorMessage(FenError error)
+{
+    switch (error) {
+        case FenOk: return "ok";
+        case FenBadPiece: return "unknown piece letter";
+        case FenBadRankLength: return "rank does not have 8 squares";
+        case FenBadRankCount: return "placement does not have 8 ranks";
+        case FenBadSideToMove: return "active color is not w or b";
+        case FenBadCastling: return "castling field is not - or KQkq";
+        case FenBadEnPassant: return "en passant square is not - or on the 3rd/6th rank";
+        case FenBadHalfmoveClock: return "halfmove clock is not a number";
+        case FenBadFullmoveNumber: return "fullmove number is not a number";
+        case FenBadKings: return "each side needs exactly one king";
+        case FenPawnOnBackRank: return "pawn on the first or last rank";
+        case FenOpponentInCheck: return "the side not to move is in check";
+        case FenTooManyPieces: return "a side has more than 8 pawns or 16 pieces";
+    }
+    return "unknown error";
+}
+
+static char *writeNumber(char *out, int value)
+{
+    char digits[8];
+    int count = 0;
+    do {
+        digits[count++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value);
+    while (count) {
+        *out++ = digits[--count];
+    }
+    return out;
+}
+
+int writeFEN(const ChessPosition &position, char *buffer)
+{
+    char *out = buffer;
+    for (int rank = 7; rank >= 0; rank--) {
+        int empty = 0;
+        for (int file = 0; file < 8; file++) {
+            int tag = position.pieceOn(squareOf(file, rank));
+            if (!tag) {
+                empty++;
+                continue;
+            }
+            if (empty) {
+                *out++ = (char)('0' + empty);
+                empty = 0;
+            }
+            *out++ = kPieceChars[pieceColorOf(tag)][pieceTypeOf(tag)];
+        }
+        if (empty) {
+            *out++ = (char)('0' + empty);
+        }
+        if (rank) {
+            *out++ = '/';
+        }
+    }
+
+    *out++ = ' ';
+    *out++ = position.sideToMove() == White ? 'w' : 'b';
+
+    *out++ = ' ';
+    int rights = position.castlingRights();
+    if (!rights) {
+        *out++ = '-';
+    }
+    if (rights & WhiteKingSide) *out++ = 'K';
+    if (rights & WhiteQueenSide) *out++ = 'Q';
+    if (rights & BlackKingSide) *out++ = 'k';
+    if (rights & BlackQueenSide) *out++ = 'q';
+
+    *out++ = ' ';
+    int epSquare = position.enPassantSquare();
+    if (epSquare == NoSquare) {
+        *out++ = '-';
+    } else {
+        *out++ = (char)('a' + fileOf(epSquare));
+        *out++ = (char)('1' + rankOf(epSquare));
+    }
+
+    *out++ = ' ';
+    out = writeNumber(out, position.halfmoveClock());
+    *out++ = ' ';
+    out = writeNumber(out, position.fullmoveNumber());
+    *out = 0;
+    return (int)(out - buffer);
+}
+
+std::string toFEN(const ChessPosition &position)
+{
+    char buffer[FenBufferSize];
+    int length = writeFEN(position, buffer);
+    return std::string(buffer, length);
+}
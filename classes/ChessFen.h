@@ -0,0 +1,65 @@
+#pragma once
+
+#include "ChessPosition.h"
+#include <string>
+#include <string_view>
+
+//
+// FEN reading and writing
+//
+// FEN is a space delimited string with 6 fields
+// 1: piece placement (from white's perspective, rank 8 first)
+// 2: active color (w or b)
+// 3: castling availability (any of KQkq, or -)
+// 4: en passant target square (in algebraic notation, or -)
+// 5: halfmove clock (number of halfmoves since the last capture or pawn advance)
+// 6: fullmove number
+// the placement field is required, trailing fields may be left off and keep their
+// defaults (white to move, no castling, no en passant, clocks 0 and 1), so EPD style
+// lines load too
+//
+// neither direction allocates, both run over the characters once, fast enough to bulk
+// load positions from training and test files
+//
+
+enum FenError
+{
+    FenOk,
+    FenBadPiece,
+    FenBadRankLength,
+    FenBadRankCount,
+    FenBadSideToMove,
+    FenBadCastling,
+    FenBadEnPassant,
+    FenBadHalfmoveClock,
+    FenBadFullmoveNumber,
+    FenBadKings,
+    FenPawnOnBackRank,
+    FenOpponentInCheck,
+    FenTooManyPieces
+};
+
+struct FenResult
+{
+    FenError error;
+    // the offending character on error, the end of the last field read on success,
+    // anything after it (an EPD operation, a score) is left to the caller
+    int offset;
+
+    bool ok() const { return error == FenOk; }
+};
+
+// big enough for any FEN writeFEN produces, terminating zero included
+constexpr int FenBufferSize = 96;
+
+// on error the position is left cleared
+// castling rights must have their king and rook in place, an en passant square without a
+// pawn that just moved two squares in front of it is dropped
+// a side with more than 8 pawns or 16 pieces is rejected, so a parsed position always packs
+// needs the attack tables, see initMagicBitboards
+FenResult parseFEN(std::string_view fen, ChessPosition &position);
+const char *fenErrorMessage(FenError error);
+
+// writes the full six fields and a terminating zero, returns the length
+int writeFEN(const ChessPosition &position, char *buffer);
+std::string toFEN(const ChessPosition &position);
@@ -0,0 +1,93 @@
+#include "ChessLazySmp.h"
+
+LazySmpSearch::LazySmpSearch(TranspositionTable &table, int threadCount)
+    : onIteration(ChessSearch::printInfo), _table(table), _stop(false)
+{
+    setThreadCount(threadCount);
+}
+
+void LazySmpSearch::setThreadCount(int threadCount)
+{
+    threadCount = threadCount < 1 ? 1 : threadCount;
+    _helpers.reset(threadCount > 1 ? new ThreadPool(threadCount - 1) : nullptr);
+    _searches.clear();
+    for (int i = 0; i < threadCount; i++) {
+        _searches.emplace_back(new ChessSearch(_table));
+        _searches.back()->setThreadIndex(i);
+        _searches.back()->setSharedStop(&_stop);
+        _searches.back()->onIteration = nullptr;
+    }
+}
+
+void LazySmpSearch::setOptions(const SearchOptions &options)
+{
+    for (auto &search : _searches) {
+        search->setOptions(options);
+    }
+}
+
+void LazySmpSearch::stop()
+{
+    _stop.store(true, std::memory_order_relaxed);
+}
+
+uint64_t LazySmpSearch::nodes() const
+{
+    uint64_t total = 0;
+    for (const auto &search : _searches) {
+        total += search->nodes();
+    }
+    return total;
+}
+
+EvalCounters LazySmpSearch::evalCounters() const
+{
+    EvalCounters total;
+    for (const auto &search : _searches) {
+        total += search->evalCounters();
+    }
+    return total;
+}
+
+SearchResult LazySmpSearch::search(const ChessPosition &root, const SearchLimits &limits)
+{
+    ChessSearch &main = *_searches[0];
+    main.onIteration = [this](const SearchInfo &info) {
+        if (!onIteration) {
+            return;
+        }
+        SearchInfo total = info;
+        total.nodes = nodes();
+        total.nps = info.timeMs > 0 ? total.nodes * 1000 / info.timeMs : 0;
+        onIteration(total);
+    };
+
+    _stop.store(false, std::memory_order_relaxed);
+    // once for all threads, before any of them starts storing
+    if (main.evaluatorChanged()) {
+        _table.clear();
+    }
+    _table.newSearch();
+
+    // helpers run until the main thread is done, node and time limits apply to the main thread only
+    SearchLimits helperLimits = limits;
+    helperLimits.nodes = 0;
+    helperLimits.time = TimeControl();
+    helperLimits.pondering = nullptr;
+    helperLimits.multiPV = 1;
+    for (size_t i = 1; i < _searches.size(); i++) {
+        ChessSearch *helper = _searches[i].get();
+        _helpers->submit([helper, &root, helperLimits]() {
+            helper->search(root, helperLimits);
+        });
+    }
+
+    SearchResult result = main.search(root, limits);
+
+    _stop.store(true, std::memory_order_relaxed);
+    if (_helpers) {
+        _helpers->wait();
+    }
+    result.nodes = nodes();
+    return result;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "ChessSearch.h"
+#include "ThreadPool.h"
+#include <memory>
+#include <vector>
+
+//
+// lazy SMP, every thread searches the same root position
+//
+// the threads only share the transposition table, each keeps its own killers,
+// countermoves and history, helpers skip some depths (see ChessSearch::setThreadIndex)
+// so they run ahead of the main thread and fill the table with results the main thread
+// then finds instead of searching, the main thread's result is the one played
+//
+class LazySmpSearch
+{
+public:
+    LazySmpSearch(TranspositionTable &table, int threadCount = 1);
+
+    void setThreadCount(int threadCount);
+    int threadCount() const { return (int)_searches.size(); }
+    void setOptions(const SearchOptions &options);
+
+    SearchResult search(const ChessPosition &root, const SearchLimits &limits);
+    // safe to call from another thread
+    void stop();
+
+    // total over every thread
+    uint64_t nodes() const;
+    // static evaluation costs of the last search, over every thread
+    EvalCounters evalCounters() const;
+
+    // called after every iteration of the main thread, the node count covers every thread
+    std::function<void(const SearchInfo &)> onIteration;
+
+private:
+    TranspositionTable &_table;
+    std::vector<std::unique_ptr<ChessSearch>> _searches;
+    std::unique_ptr<ThreadPool> _helpers;
+    std::atomic<bool> _stop;
+};
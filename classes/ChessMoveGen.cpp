@@ -0,0 +1,265 @@
+#include "ChessMoveGen.h"
+
+//
+// between and line tables, generated at compile time
+//
+struct LineTables
+{
+    uint64_t between[64][64];
+    uint64_t line[64][64];
+};
+
+static constexpr LineTables makeLineTables()
+{
+    LineTables tables{};
+    const int directions[8][2] = {
+        {1, 0}, {-1, 0}, {0, 1}, {0, -1},
+        {1, 1}, {-1, -1}, {1, -1}, {-1, 1}
+    };
+
+    for (int square = 0; square < 64; square++) {
+        int file = square % 8;
+        int rank = square / 8;
+        for (int d = 0; d < 8; d++) {
+            // the full line is this ray, the opposite ray and the square itself
+            uint64_t fullLine = 1ULL << square;
+            for (int sign = -1; sign <= 1; sign += 2) {
+                int f = file + sign * directions[d][0];
+                int r = rank + sign * directions[d][1];
+                while (f >= 0 && f < 8 && r >= 0 && r < 8) {
+                    fullLine |= 1ULL << (r * 8 + f);
+                    f += sign * directions[d][0];
+                    r += sign * directions[d][1];
+                }
+            }
+
+            uint64_t ray = 0ULL;
+            int f = file + directions[d][0];
+            int r = rank + directions[d][1];
+            while (f >= 0 && f < 8 && r >= 0 && r < 8) {
+                int target = r * 8 + f;
+                tables.between[square][target] = ray;
+                tables.line[square][target] = fullLine;
+                ray |= 1ULL << target;
+                f += directions[d][0];
+                r += directions[d][1];
+            }
+        }
+    }
+    return tables;
+}
+
+static constexpr LineTables kLineTables = makeLineTables();
+
+uint64_t betweenSquares(int from, int to)
+{
+    return kLineTables.between[from][to];
+}
+
+uint64_t lineThrough(int from, int to)
+{
+    return kLineTables.line[from][to];
+}
+
+//
+// helpers for adding moves
+//
+static inline void addPromotions(MoveList &moves, int from, int to, MoveGenType type)
+{
+    if (type != GenQuiets) {
+        moves.add(from, to, Pawn, BitMove::promotionFlags(Queen));
+    }
+    if (type != GenCaptures) {
+        moves.add(from, to, Pawn, BitMove::promotionFlags(Rook));
+        moves.add(from, to, Pawn, BitMove::promotionFlags(Bishop));
+        moves.add(from, to, Pawn, BitMove::promotionFlags(Knight));
+    }
+}
+
+static inline void addMoves(MoveList &moves, int from, uint64_t targets, ChessPiece piece)
+{
+    while (targets) {
+        moves.add(from, popLsb(targets), piece);
+    }
+}
+
+// en passant can expose the king along the rank of both pawns, so it is simply played out
+static bool enPassantIsLegal(const ChessPosition &position, int from, int to, int kingSquare)
+{
+    int us = position.sideToMove();
+    int them = us ^ 1;
+    int captureSquare = to ^ 8;
+    uint64_t occupied = (position.occupied() ^ (1ULL << from) ^ (1ULL << captureSquare)) | (1ULL << to);
+
+    uint64_t rookLike = position.pieces(them, Rook) | position.pieces(them, Queen);
+    uint64_t bishopLike = position.pieces(them, Bishop) | position.pieces(them, Queen);
+    uint64_t attackers = (getRookAttacks(kingSquare, occupied) & rookLike)
+                       | (getBishopAttacks(kingSquare, occupied) & bishopLike)
+                       | (knightAttacks(kingSquare) & position.pieces(them, Knight))
+                       | (pawnAttacks(us, kingSquare) & position.pieces(them, Pawn) & ~(1ULL << captureSquare));
+    return attackers == 0;
+}
+
+void generateLegalMoves(const ChessPosition &position, MoveList &moves, MoveGenType type, uint64_t fromSquares)
+{
+    int us = position.sideToMove();
+    int them = us ^ 1;
+    uint64_t ours = position.occupancy(us);
+    uint64_t theirs = position.occupancy(them);
+    uint64_t occupied = ours | theirs;
+    int kingSquare = position.kingSquare(us);
+
+    // squares each generation type may land on
+    uint64_t targetMask = (type == GenCaptures) ? theirs : (type == GenQuiets) ? ~occupied : ~ours;
+
+    // king moves, tested with the king lifted off the board so it cannot hide behind itself
+    bool kingMoves = fromSquares & (1ULL << kingSquare);
+    uint64_t kingTargets = kingMoves ? kingAttacks(kingSquare) & targetMask : 0ULL;
+    uint64_t withoutKing = occupied ^ (1ULL << kingSquare);
+    while (kingTargets) {
+        int to = popLsb(kingTargets);
+        if (!(position.attackersTo(to, withoutKing) & theirs)) {
+            moves.add(kingSquare, to, King);
+        }
+    }
+
+    uint64_t checkers = position.attackersTo(kingSquare, occupied) & theirs;
+    if (popCount(checkers) > 1) {
+        // double check, only the king can move
+        return;
+    }
+
+    // in single check every other piece must capture the checker or block the line
+    uint64_t checkMask = ~0ULL;
+    if (checkers) {
+        int checker = lsb(checkers);
+        checkMask = checkers | betweenSquares(kingSquare, checker);
+    }
+
+    // pinned pieces are found by looking for exactly one of our pieces between the king and an enemy slider
+    uint64_t pinned = 0ULL;
+    uint64_t snipers = (getRookAttacks(kingSquare, theirs) & (position.pieces(them, Rook) | position.pieces(them, Queen)))
+                     | (getBishopAttacks(kingSquare, theirs) & (position.pieces(them, Bishop) | position.pieces(them, Queen)));
+    while (snipers) {
+        int sniper = popLsb(snipers);
+        uint64_t blockers = betweenSquares(kingSquare, sniper) & occupied;
+        if (blockers && !(blockers & (blockers - 1)) && (blockers & ours)) {
+            pinned |= blockers;
+        }
+    }
+
+    uint64_t pieceMask = targetMask & checkMask;
+
+    // knights, a pinned knight can never move
+    uint64_t knights = position.pieces(us, Knight) & ~pinned & fromSquares;
+    while (knights) {
+        int from = popLsb(knights);
+        addMoves(moves, from, knightAttacks(from) & pieceMask, Knight);
+    }
+
+    // sliders, pinned ones stay on the line through the king
+    uint64_t bishops = (position.pieces(us, Bishop) | position.pieces(us, Queen)) & fromSquares;
+    while (bishops) {
+        int from = popLsb(bishops);
+        uint64_t targets = getBishopAttacks(from, occupied) & pieceMask;
+        if (pinned & (1ULL << from)) {
+            targets &= lineThrough(kingSquare, from);
+        }
+        addMoves(moves, from, targets, static_cast<ChessPiece>(pieceTypeOf(position.pieceOn(from))));
+    }
+    uint64_t rooks = (position.pieces(us, Rook) | position.pieces(us, Queen)) & fromSquares;
+    while (rooks) {
+        int from = popLsb(rooks);
+        uint64_t targets = getRookAttacks(from, occupied) & pieceMask;
+        if (pinned & (1ULL << from)) {
+            targets &= lineThrough(kingSquare, from);
+        }
+        addMoves(moves, from, targets, static_cast<ChessPiece>(pieceTypeOf(position.pieceOn(from))));
+    }
+
+    // pawns
+    int forward = (us == White) ? 8 : -8;
+    int promotionRank = (us == White) ? 7 : 0;
+    int doublePushRank = (us == White) ? 1 : 6;
+    int enPassant = position.enPassantSquare();
+    uint64_t pawns = position.pieces(us, Pawn) & fromSquares;
+    while (pawns) {
+        int from = popLsb(pawns);
+        uint64_t allowed = checkMask;
+        if (pinned & (1ULL << from)) {
+            allowed &= lineThrough(kingSquare, from);
+        }
+
+        // captures
+        uint64_t captures = pawnAttacks(us, from) & theirs & allowed;
+        while (captures) {
+            int to = popLsb(captures);
+            if (rankOf(to) == promotionRank) {
+                addPromotions(moves, from, to, type);
+            } else if (type != GenQuiets) {
+                moves.add(from, to, Pawn);
+            }
+        }
+        if (type != GenQuiets && enPassant != NoSquare && (pawnAttacks(us, from) & (1ULL << enPassant))) {
+            if (enPassantIsLegal(position, from, enPassant, kingSquare)) {
+                moves.add(from, enPassant, Pawn, MoveEnPassant);
+            }
+        }
+
+        // pushes
+        int to = from + forward;
+        if (occupied & (1ULL << to)) {
+            continue;
+        }
+        if (allowed & (1ULL << to)) {
+            if (rankOf(to) == promotionRank) {
+                addPromotions(moves, from, to, type);
+            } else if (type != GenCaptures) {
+                moves.add(from, to, Pawn);
+            }
+        }
+        if (type != GenCaptures && rankOf(from) == doublePushRank) {
+            int doubleTo = to + forward;
+            if (!(occupied & (1ULL << doubleTo)) && (allowed & (1ULL << doubleTo))) {
+                moves.add(from, doubleTo, Pawn, MoveDoublePush);
+            }
+        }
+    }
+
+    // castling, never out of check, and the king may not pass through an attacked square
+    if (type == GenCaptures || checkers || !kingMoves) {
+        return;
+    }
+    int rights = position.castlingRights() & (us == White ? (WhiteKingSide | WhiteQueenSide) : (BlackKingSide | BlackQueenSide));
+    if (!rights) {
+        return;
+    }
+    int backRank = (us == White) ? 0 : 56;
+    int kingSide = (us == White) ? WhiteKingSide : BlackKingSide;
+    int queenSide = (us == White) ? WhiteQueenSide : BlackQueenSide;
+    if ((rights & kingSide)
+        && !(occupied & (3ULL << (backRank + 5)))
+        && !(position.attackersTo(backRank + 5, occupied) & theirs)
+        && !(position.attackersTo(backRank + 6, occupied) & theirs)) {
+        moves.add(kingSquare, backRank + 6, King, MoveCastle);
+    }
+    if ((rights & queenSide)
+        && !(occupied & (7ULL << (backRank + 1)))
+        && !(position.attackersTo(backRank + 3, occupied) & theirs)
+        && !(position.attackersTo(backRank + 2, occupied) & theirs)) {
+        moves.add(kingSquare, backRank + 2, King, MoveCastle);
+    }
+}
+
+std::string moveToString(const BitMove &move)
+{
+    std::string s;
+    s += (char)('a' + fileOf(move.from));
+    s += (char)('1' + rankOf(move.from));
+    s += (char)('a' + fileOf(move.to));
+    s += (char)('1' + rankOf(move.to));
+    if (move.kind() == MovePromotion) {
+        s += " pnbrqk"[move.promotion()];
+    }
+    return s;
+}
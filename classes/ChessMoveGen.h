@@ -0,0 +1,62 @@
+#pragma once
+
+#include "ChessPosition.h"
+#include "MagicBitboards.h"
+#include <string>
+
+//
+// legal move generation for ChessPosition
+// checkers and pins are worked out once per position so every generated move
+// is legal by construction, no make / is-attacked / unmake test is needed
+//
+
+constexpr int MaxMoves = 256;
+
+// fixed capacity move list, lives on the stack so generation never allocates
+struct MoveList
+{
+    BitMove moves[MaxMoves];
+    int count = 0;
+
+    void add(int from, int to, ChessPiece piece, int flags = MoveNormal) { moves[count++] = BitMove(from, to, piece, flags); }
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+    void clear() { count = 0; }
+    BitMove *begin() { return moves; }
+    BitMove *end() { return moves + count; }
+    const BitMove *begin() const { return moves; }
+    const BitMove *end() const { return moves + count; }
+    BitMove &operator[](int index) { return moves[index]; }
+    const BitMove &operator[](int index) const { return moves[index]; }
+};
+
+// GenCaptures is captures, en passant and queen promotions
+// GenQuiets is everything else, so the two together are exactly GenAll
+enum MoveGenType
+{
+    GenCaptures,
+    GenQuiets,
+    GenAll
+};
+
+inline uint64_t pawnAttacks(int color, int square) { return PawnAttacks[color][square]; }
+inline uint64_t knightAttacks(int square) { return KnightAttacks[square]; }
+inline uint64_t kingAttacks(int square) { return KingAttacks[square]; }
+
+// squares strictly between two aligned squares, 0 if they are not on a common line
+uint64_t betweenSquares(int from, int to);
+// the whole rank, file or diagonal through two aligned squares, 0 if they are not aligned
+uint64_t lineThrough(int from, int to);
+
+// append all legal moves of the requested type for the side to move
+// fromSquares limits generation to pieces standing on those squares
+void generateLegalMoves(const ChessPosition &position, MoveList &moves, MoveGenType type = GenAll, uint64_t fromSquares = ~0ULL);
+
+// true for captures, en passant and promotions, the moves quiescence looks at
+inline bool isTactical(const ChessPosition &position, const BitMove &move)
+{
+    return position.pieceOn(move.to) || move.kind() == MoveEnPassant || move.kind() == MovePromotion;
+}
+
+// long algebraic (uci) notation, e.g. e2e4 or e7e8q
+std::string moveToString(const BitMove &move);
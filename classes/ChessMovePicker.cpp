@@ -0,0 +1,278 @@
+#include "ChessMovePicker.h"
+#include "ChessEval.h"
+#include "ChessSee.h"
+#include "TranspositionTable.h"
+#include <cstring>
+
+void MoveHistory::clear()
+{
+    for (auto &killer : killers) {
+        killer[0] = BitMove();
+        killer[1] = BitMove();
+    }
+    for (auto &byColor : counterMoves) {
+        for (auto &byPiece : byColor) {
+            for (BitMove &move : byPiece) {
+                move = BitMove();
+            }
+        }
+    }
+    std::memset(butterfly, 0, sizeof(butterfly));
+}
+
+void MoveHistory::addKiller(int ply, const BitMove &move)
+{
+    if (!(killers[ply][0] == move)) {
+        killers[ply][1] = killers[ply][0];
+        killers[ply][0] = move;
+    }
+}
+
+void MoveHistory::setCounterMove(int color, const BitMove &previous, const BitMove &move)
+{
+    if (previous.piece != NoPiece) {
+        counterMoves[color][previous.piece][previous.to] = move;
+    }
+}
+
+void MoveHistory::updateHistory(int color, const BitMove &move, int bonus)
+{
+    // history gravity, entries near the limit move less so nothing saturates
+    int16_t &entry = butterfly[color][move.from][move.to];
+    int clamped = bonus > MaxHistory ? MaxHistory : bonus < -MaxHistory ? -MaxHistory : bonus;
+    int magnitude = clamped < 0 ? -clamped : clamped;
+    entry = (int16_t)(entry + clamped - entry * magnitude / MaxHistory);
+}
+
+// decode a table move by generating the legal moves of the piece on its from square
+static BitMove findTableMove(const ChessPosition &position, uint16_t tableMove)
+{
+    int from = tableMove & 63;
+    int tag = position.pieceOn(from);
+    if (!tag || pieceColorOf(tag) != position.sideToMove()) {
+        return BitMove();
+    }
+    MoveList moves;
+    generateLegalMoves(position, moves, GenAll, 1ULL << from);
+    for (const BitMove &move : moves) {
+        if (encodeMove(move) == tableMove) {
+            return move;
+        }
+    }
+    return BitMove();
+}
+
+MovePicker::MovePicker(const ChessPosition &position, uint16_t tableMove, const MoveHistory &history, int ply, const BitMove &previous)
+    : _position(position), _history(history), _skipQuiets(false), _quiescence(false),
+      _current(0), _badCaptureCount(0), _badCaptureIndex(0)
+{
+    _tableMove = tableMove ? findTableMove(position, tableMove) : BitMove();
+    _killers[0] = history.killers[ply][0];
+    _killers[1] = history.killers[ply][1];
+    _counterMove = previous.piece != NoPiece ? history.counterMoves[position.sideToMove() ^ 1][previous.piece][previous.to] : BitMove();
+
+    if (position.inCheck()) {
+        _stage = _tableMove.piece != NoPiece ? StageTableMove : StageGenerateEvasions;
+    } else {
+        _stage = _tableMove.piece != NoPiece ? StageTableMove : StageGenerateCaptures;
+    }
+}
+
+MovePicker::MovePicker(const ChessPosition &position, const MoveHistory &history)
+    : _position(position), _history(history), _skipQuiets(true), _quiescence(true),
+      _current(0), _badCaptureCount(0), _badCaptureIndex(0)
+{
+    if (position.inCheck()) {
+        _stage = StageGenerateEvasions;
+    } else {
+        generateLegalMoves(position, _moves, GenCaptures);
+        scoreCaptures();
+        _stage = StageQuiescenceCaptures;
+    }
+}
+
+bool MovePicker::isSpecial(const BitMove &move) const
+{
+    return move == _tableMove || move == _killers[0] || move == _killers[1] || move == _counterMove;
+}
+
+bool MovePicker::isLegalQuiet(const BitMove &move) const
+{
+    if (move.piece == NoPiece || move == _tableMove
+        || _position.pieceOn(move.from) != pieceTag(_position.sideToMove(), move.piece)
+        || _position.pieceOn(move.to)) {
+        return false;
+    }
+    MoveList moves;
+    generateLegalMoves(_position, moves, GenQuiets, 1ULL << move.from);
+    for (const BitMove &candidate : moves) {
+        if (candidate == move) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void MovePicker::scoreCaptures()
+{
+    for (int i = 0; i < _moves.size(); i++) {
+        const BitMove &move = _moves[i];
+        int victim = move.kind() == MoveEnPassant ? Pawn : pieceTypeOf(_position.pieceOn(move.to));
+        _scores[i] = kPieceValues[victim] * 8 - move.piece
+                   + (move.kind() == MovePromotion ? kPieceValues[move.promotion()] : 0);
+    }
+}
+
+void MovePicker::scoreQuiets()
+{
+    int us = _position.sideToMove();
+    for (int i = 0; i < _moves.size(); i++) {
+        const BitMove &move = _moves[i];
+        _scores[i] = _history.butterfly[us][move.from][move.to];
+    }
+}
+
+const BitMove &MovePicker::pickBest()
+{
+    int best = _current;
+    for (int i = _current + 1; i < _moves.size(); i++) {
+        if (_scores[i] > _scores[best]) {
+            best = i;
+        }
+    }
+    if (best != _current) {
+        BitMove move = _moves[best];
+        int score = _scores[best];
+        _moves[best] = _moves[_current];
+        _scores[best] = _scores[_current];
+        _moves[_current] = move;
+        _scores[_current] = score;
+    }
+    return _moves[_current++];
+}
+
+bool MovePicker::next(BitMove &move)
+{
+    while (true) {
+        switch (_stage) {
+        case StageTableMove:
+            _stage = _position.inCheck() ? StageGenerateEvasions : StageGenerateCaptures;
+            move = _tableMove;
+            return true;
+
+        case StageGenerateCaptures:
+            generateLegalMoves(_position, _moves, GenCaptures);
+            scoreCaptures();
+            _current = 0;
+            _stage = StageGoodCaptures;
+            break;
+
+        case StageGoodCaptures:
+            while (_current < _moves.size()) {
+                const BitMove &candidate = pickBest();
+                if (candidate == _tableMove) {
+                    continue;
+                }
+                // losing captures wait until after the quiet moves
+                if (!seeGreaterEqual(_position, candidate)) {
+                    _badCaptures[_badCaptureCount++] = candidate;
+                    continue;
+                }
+                move = candidate;
+                return true;
+            }
+            _stage = StageKiller1;
+            break;
+
+        case StageKiller1:
+        case StageKiller2:
+        case StageCounterMove: {
+            const BitMove &candidate = _stage == StageKiller1 ? _killers[0]
+                                     : _stage == StageKiller2 ? _killers[1] : _counterMove;
+            bool duplicate = (_stage == StageKiller2 && candidate == _killers[0])
+                          || (_stage == StageCounterMove && (candidate == _killers[0] || candidate == _killers[1]));
+            _stage++;
+            if (!_skipQuiets && !duplicate && isLegalQuiet(candidate)) {
+                move = candidate;
+                return true;
+            }
+            break;
+        }
+
+        case StageGenerateQuiets:
+            if (!_skipQuiets) {
+                _moves.clear();
+                generateLegalMoves(_position, _moves, GenQuiets);
+                scoreQuiets();
+                _current = 0;
+            }
+            _stage = StageQuiets;
+            break;
+
+        case StageQuiets:
+            while (!_skipQuiets && _current < _moves.size()) {
+                const BitMove &candidate = pickBest();
+                if (isSpecial(candidate)) {
+                    continue;
+                }
+                move = candidate;
+                return true;
+            }
+            _stage = StageBadCaptures;
+            break;
+
+        case StageBadCaptures:
+            if (_badCaptureIndex < _badCaptureCount) {
+                move = _badCaptures[_badCaptureIndex++];
+                return true;
+            }
+            _stage = StageDone;
+            break;
+
+        case StageGenerateEvasions: {
+            // few moves get out of check, so they are all generated and ordered at once
+            generateLegalMoves(_position, _moves, GenAll);
+            int us = _position.sideToMove();
+            for (int i = 0; i < _moves.size(); i++) {
+                const BitMove &evasion = _moves[i];
+                if (isTactical(_position, evasion)) {
+                    int victim = evasion.kind() == MoveEnPassant ? Pawn : pieceTypeOf(_position.pieceOn(evasion.to));
+                    _scores[i] = (1 << 20) + kPieceValues[victim] * 8 - evasion.piece;
+                } else {
+                    _scores[i] = _history.butterfly[us][evasion.from][evasion.to];
+                }
+            }
+            _current = 0;
+            _stage = StageEvasions;
+            break;
+        }
+
+        case StageEvasions:
+            while (_current < _moves.size()) {
+                const BitMove &candidate = pickBest();
+                if (candidate == _tableMove) {
+                    continue;
+                }
+                move = candidate;
+                return true;
+            }
+            _stage = StageDone;
+            break;
+
+        case StageQuiescenceCaptures:
+            while (_current < _moves.size()) {
+                const BitMove &candidate = pickBest();
+                if (!seeGreaterEqual(_position, candidate)) {
+                    continue;
+                }
+                move = candidate;
+                return true;
+            }
+            _stage = StageDone;
+            break;
+
+        default:
+            return false;
+        }
+    }
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "ChessMoveGen.h"
+#include <cstdint>
+
+//
+// staged move ordering for the chess search
+//
+// moves come out in the order most likely to cause a cutoff:
+//   1. the transposition table move
+//   2. captures that do not lose material, most valuable victim / least valuable attacker
+//   3. the two killer moves for this ply and the countermove to the previous move
+//   4. the remaining quiet moves by history score
+//   5. captures that lose material
+// each stage is generated only when the one before it runs out, so a cutoff on the
+// table move or a good capture never pays for quiet move generation
+//
+
+constexpr int MaxSearchPly = 128;
+
+// the move ordering statistics a search thread learns as it goes
+struct MoveHistory
+{
+    static constexpr int MaxHistory = 16384;
+
+    // quiet moves that caused a cutoff at each ply
+    BitMove killers[MaxSearchPly + 1][2];
+    // the quiet reply that refuted a move, by color, piece and destination of that move
+    BitMove counterMoves[2][7][64];
+    // butterfly history, by color, from and to
+    int16_t butterfly[2][64][64];
+
+    void clear();
+    // shift the killers at ply and remember the countermove to previous
+    void addKiller(int ply, const BitMove &move);
+    void setCounterMove(int color, const BitMove &previous, const BitMove &move);
+    // move the history toward MaxHistory by bonus, or toward -MaxHistory for a negative bonus
+    void updateHistory(int color, const BitMove &move, int bonus);
+};
+
+class MovePicker
+{
+public:
+    // main search, previous is the move that led here, or an empty move at the root
+    MovePicker(const ChessPosition &position, uint16_t tableMove, const MoveHistory &history, int ply, const BitMove &previous);
+    // quiescence, captures that do not lose material or every evasion when in check
+    MovePicker(const ChessPosition &position, const MoveHistory &history);
+
+    // the next move in order, false once every stage is exhausted
+    bool next(BitMove &move);
+
+    // quiet moves not yet returned are skipped, used by move count pruning
+    void skipQuiets() { _skipQuiets = true; }
+
+private:
+    enum Stage
+    {
+        StageTableMove,
+        StageGenerateCaptures,
+        StageGoodCaptures,
+        StageKiller1,
+        StageKiller2,
+        StageCounterMove,
+        StageGenerateQuiets,
+        StageQuiets,
+        StageBadCaptures,
+        StageGenerateEvasions,
+        StageEvasions,
+        StageQuiescenceCaptures,
+        StageDone
+    };
+
+    // true if move is a legal quiet move here, killers and countermoves come from other positions
+    bool isLegalQuiet(const BitMove &move) const;
+    bool isSpecial(const BitMove &move) const;
+    void scoreCaptures();
+    void scoreQuiets();
+    // move the best scoring remaining move to _current and return it
+    const BitMove &pickBest();
+
+    const ChessPosition &_position;
+    const MoveHistory &_history;
+    int _stage;
+    bool _skipQuiets;
+    bool _quiescence;
+
+    BitMove _tableMove;
+    BitMove _killers[2];
+    BitMove _counterMove;
+
+    MoveList _moves;
+    int _scores[MaxMoves];
+    int _current;
+
+    BitMove _badCaptures[MaxMoves];
+    int _badCaptureCount;
+    int _badCaptureIndex;
+};
@@ -0,0 +1,458 @@
+#include "ChessNnue.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <memory>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define NNUE_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// lets the SIMD kernels be compiled without building everything for that instruction set
+#if defined(NNUE_X86) && (defined(__GNUC__) || defined(__clang__))
+#define NNUE_TARGET(isa) __attribute__((target(isa)))
+#else
+#define NNUE_TARGET(isa)
+#endif
+
+static const char kNnueMagic[4] = { 'C', 'B', 'N', 'N' };
+static const uint32_t kNnueVersion = 1;
+
+struct NnueNetwork
+{
+    alignas(64) int16_t featureWeights[NnueInputs * NnueHidden];
+    alignas(64) int16_t featureBiases[NnueHidden];
+    alignas(64) int8_t outputWeights[2 * NnueHidden];
+    int32_t outputBias;
+};
+
+static std::unique_ptr<NnueNetwork> LoadedNetwork;
+
+//
+// accumulator kernels
+// out = in + the added feature rows - the removed ones, and the output layer's dot product
+//
+
+static void addRowsScalar(int16_t *out, const int16_t *in, const int16_t *weights,
+                          const int *added, int addedCount, const int *removed, int removedCount)
+{
+    std::memcpy(out, in, NnueHidden * sizeof(int16_t));
+    for (int i = 0; i < addedCount; i++) {
+        const int16_t *row = weights + added[i] * NnueHidden;
+        for (int j = 0; j < NnueHidden; j++) {
+            out[j] += row[j];
+        }
+    }
+    for (int i = 0; i < removedCount; i++) {
+        const int16_t *row = weights + removed[i] * NnueHidden;
+        for (int j = 0; j < NnueHidden; j++) {
+            out[j] -= row[j];
+        }
+    }
+}
+
+static int32_t outputSumScalar(const int16_t *us, const int16_t *them, const int8_t *weights)
+{
+    int32_t sum = 0;
+    for (int i = 0; i < NnueHidden; i++) {
+        sum += std::clamp<int>(us[i], 0, NnueActivationMax) * weights[i];
+        sum += std::clamp<int>(them[i], 0, NnueActivationMax) * weights[NnueHidden + i];
+    }
+    return sum;
+}
+
+#if defined(NNUE_X86)
+
+NNUE_TARGET("sse4.1")
+static void addRowsSse41(int16_t *out, const int16_t *in, const int16_t *weights,
+                         const int *added, int addedCount, const int *removed, int removedCount)
+{
+    for (int c = 0; c < NnueHidden; c += 8) {
+        __m128i acc = _mm_load_si128((const __m128i *)(in + c));
+        for (int i = 0; i < addedCount; i++) {
+            acc = _mm_add_epi16(acc, _mm_load_si128((const __m128i *)(weights + added[i] * NnueHidden + c)));
+        }
+        for (int i = 0; i < removedCount; i++) {
+            acc = _mm_sub_epi16(acc, _mm_load_si128((const __m128i *)(weights + removed[i] * NnueHidden + c)));
+        }
+        _mm_store_si128((__m128i *)(out + c), acc);
+    }
+}
+
+// packus clips negatives to 0, the upper clip is done before packing
+NNUE_TARGET("sse4.1")
+static int32_t outputSumSse41(const int16_t *us, const int16_t *them, const int8_t *weights)
+{
+    const __m128i maxActivation = _mm_set1_epi16(NnueActivationMax);
+    const __m128i ones = _mm_set1_epi16(1);
+    __m128i sum = _mm_setzero_si128();
+    const int16_t *halves[2] = { us, them };
+    for (int half = 0; half < 2; half++) {
+        for (int c = 0; c < NnueHidden; c += 16) {
+            __m128i low = _mm_min_epi16(_mm_load_si128((const __m128i *)(halves[half] + c)), maxActivation);
+            __m128i high = _mm_min_epi16(_mm_load_si128((const __m128i *)(halves[half] + c + 8)), maxActivation);
+            __m128i activations = _mm_packus_epi16(low, high);
+            __m128i products = _mm_maddubs_epi16(activations, _mm_load_si128((const __m128i *)(weights + half * NnueHidden + c)));
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(products, ones));
+        }
+    }
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4e));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xb1));
+    return _mm_cvtsi128_si32(sum);
+}
+
+NNUE_TARGET("avx2")
+static void addRowsAvx2(int16_t *out, const int16_t *in, const int16_t *weights,
+                        const int *added, int addedCount, const int *removed, int removedCount)
+{
+    for (int c = 0; c < NnueHidden; c += 16) {
+        __m256i acc = _mm256_load_si256((const __m256i *)(in + c));
+        for (int i = 0; i < addedCount; i++) {
+            acc = _mm256_add_epi16(acc, _mm256_load_si256((const __m256i *)(weights + added[i] * NnueHidden + c)));
+        }
+        for (int i = 0; i < removedCount; i++) {
+            acc = _mm256_sub_epi16(acc, _mm256_load_si256((const __m256i *)(weights + removed[i] * NnueHidden + c)));
+        }
+        _mm256_store_si256((__m256i *)(out + c), acc);
+    }
+}
+
+// packus works within each 128 bit lane, the permute puts the bytes back in order
+NNUE_TARGET("avx2")
+static int32_t outputSumAvx2(const int16_t *us, const int16_t *them, const int8_t *weights)
+{
+    const __m256i maxActivation = _mm256_set1_epi16(NnueActivationMax);
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i sum = _mm256_setzero_si256();
+    const int16_t *halves[2] = { us, them };
+    for (int half = 0; half < 2; half++) {
+        for (int c = 0; c < NnueHidden; c += 32) {
+            __m256i low = _mm256_min_epi16(_mm256_load_si256((const __m256i *)(halves[half] + c)), maxActivation);
+            __m256i high = _mm256_min_epi16(_mm256_load_si256((const __m256i *)(halves[half] + c + 16)), maxActivation);
+            __m256i activations = _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), 0xd8);
+            __m256i products = _mm256_maddubs_epi16(activations, _mm256_load_si256((const __m256i *)(weights + half * NnueHidden + c)));
+            sum = _mm256_add_epi32(sum, _mm256_madd_epi16(products, ones));
+        }
+    }
+    __m128i total = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    total = _mm_add_epi32(total, _mm_shuffle_epi32(total, 0x4e));
+    total = _mm_add_epi32(total, _mm_shuffle_epi32(total, 0xb1));
+    return _mm_cvtsi128_si32(total);
+}
+
+#endif
+
+static NnueSimd cpuSimd()
+{
+#if defined(__AVX2__)
+    return NnueAvx2;
+#elif defined(NNUE_X86) && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return NnueAvx2;
+    }
+    return __builtin_cpu_supports("sse4.1") ? NnueSse41 : NnueScalar;
+#elif defined(NNUE_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    bool sse41 = (info[2] & (1 << 19)) != 0;
+    // AVX2 also needs the OS to save the ymm registers
+    bool osAvx = (info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6;
+    __cpuidex(info, 7, 0);
+    if (osAvx && (info[1] & (1 << 5))) {
+        return NnueAvx2;
+    }
+    return sse41 ? NnueSse41 : NnueScalar;
+#else
+    return NnueScalar;
+#endif
+}
+
+static NnueSimd ActiveSimd = cpuSimd();
+
+NnueSimd setNnueSimd(NnueSimd limit)
+{
+    ActiveSimd = std::min(limit, cpuSimd());
+    return ActiveSimd;
+}
+
+NnueSimd nnueSimd()
+{
+    return ActiveSimd;
+}
+
+const char *nnueSimdName()
+{
+    switch (ActiveSimd) {
+        case NnueAvx2: return "avx2";
+        case NnueSse41: return "sse4.1";
+        default: return "scalar";
+    }
+}
+
+static inline void addRows(int16_t *out, const int16_t *in, const int *added, int addedCount, const int *removed, int removedCount)
+{
+    const int16_t *weights = LoadedNetwork->featureWeights;
+#if defined(NNUE_X86)
+    if (ActiveSimd == NnueAvx2) {
+        addRowsAvx2(out, in, weights, added, addedCount, removed, removedCount);
+        return;
+    }
+    if (ActiveSimd == NnueSse41) {
+        addRowsSse41(out, in, weights, added, addedCount, removed, removedCount);
+        return;
+    }
+#endif
+    addRowsScalar(out, in, weights, added, addedCount, removed, removedCount);
+}
+
+static inline int outputScore(const int16_t *us, const int16_t *them)
+{
+    const int8_t *weights = LoadedNetwork->outputWeights;
+    int32_t sum;
+#if defined(NNUE_X86)
+    if (ActiveSimd == NnueAvx2) {
+        sum = outputSumAvx2(us, them, weights);
+    } else if (ActiveSimd == NnueSse41) {
+        sum = outputSumSse41(us, them, weights);
+    } else
+#endif
+    {
+        sum = outputSumScalar(us, them, weights);
+    }
+    return (sum + LoadedNetwork->outputBias) / NnueOutputDivisor;
+}
+
+//
+// features
+//
+
+// seen from perspective, the king's half of the board and whether it has left its first two ranks
+static inline int kingBucket(int perspective, int kingSquare)
+{
+    int relative = perspective == White ? kingSquare : kingSquare ^ 56;
+    return (rankOf(relative) >= 2 ? 2 : 0) + (fileOf(relative) >= 4 ? 1 : 0);
+}
+
+static inline int featureIndex(int perspective, int bucket, int square, int tag)
+{
+    int relativeSquare = perspective == White ? square : square ^ 56;
+    int relativeColor = pieceColorOf(tag) == perspective ? 0 : 1;
+    return ((bucket * 2 + relativeColor) * 6 + pieceTypeOf(tag) - 1) * 64 + relativeSquare;
+}
+
+static void refreshHalf(const ChessPosition &position, int perspective, int16_t *out)
+{
+    int bucket = kingBucket(perspective, position.kingSquare(perspective));
+    int features[32];
+    int count = 0;
+    uint64_t pieces = position.occupied();
+    while (pieces && count < 32) {
+        int square = popLsb(pieces);
+        features[count++] = featureIndex(perspective, bucket, square, position.pieceOn(square));
+    }
+    addRows(out, LoadedNetwork->featureBiases, features, count, nullptr, 0);
+}
+
+//
+// network files
+//
+
+bool loadNnue(const std::string &path, std::string &error)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+    char magic[4];
+    uint32_t header[3];
+    file.read(magic, sizeof(magic));
+    file.read((char *)header, sizeof(header));
+    if (!file || std::memcmp(magic, kNnueMagic, sizeof(magic))) {
+        error = path + " is not a network file";
+        return false;
+    }
+    if (header[0] != kNnueVersion || header[1] != NnueInputs || header[2] != NnueHidden) {
+        error = path + " has version " + std::to_string(header[0]) + ", " + std::to_string(header[1]) + " inputs and "
+              + std::to_string(header[2]) + " hidden, expected version " + std::to_string(kNnueVersion) + ", "
+              + std::to_string(NnueInputs) + " and " + std::to_string(NnueHidden);
+        return false;
+    }
+
+    auto network = std::make_unique<NnueNetwork>();
+    file.read((char *)network->featureWeights, sizeof(network->featureWeights));
+    file.read((char *)network->featureBiases, sizeof(network->featureBiases));
+    file.read((char *)network->outputWeights, sizeof(network->outputWeights));
+    file.read((char *)&network->outputBias, sizeof(network->outputBias));
+    if (!file || file.peek() != std::ifstream::traits_type::eof()) {
+        error = path + " has the wrong size";
+        return false;
+    }
+    LoadedNetwork = std::move(network);
+    return true;
+}
+
+bool nnueLoaded()
+{
+    return LoadedNetwork != nullptr;
+}
+
+bool writePsqtNnue(const std::string &path)
+{
+    // each own piece adds its material and piece-square value, half middlegame half endgame,
+    // in units of 4 centipawns to neurons of its own, enough of them that a normal set of
+    // pieces never reaches the clip at 127
+    // pawns use one neuron per file, pieces one group per file with the value spread over
+    // 2 or 4 neurons, the king one neuron offset to stay positive
+    // the same weights serve every king bucket, a trained network is free to tell them apart
+    constexpr int kFirstNeuron[7] = { 0, 0, 8, 24, 40, 72, 104 };
+    constexpr int kSpread[7] = { 0, 1, 2, 2, 4, 4, 1 };
+    constexpr int kUnit = 4;
+    constexpr int kKingOffset = 20;
+
+    auto network = std::make_unique<NnueNetwork>();
+    for (int bucket = 0; bucket < NnueKingBuckets; bucket++) {
+        for (int piece = Pawn; piece <= King; piece++) {
+            for (int square = 0; square < 64; square++) {
+                PhaseScore value = kPieceSquare.values[White][piece][square];
+                int units = (value.mg + value.eg + kUnit) / (2 * kUnit) + (piece == King ? kKingOffset : 0);
+                int16_t *row = network->featureWeights + featureIndex(White, bucket, square, piece) * NnueHidden;
+                int first = kFirstNeuron[piece] + (piece == King ? 0 : fileOf(square) * kSpread[piece]);
+                for (int i = 0; i < kSpread[piece]; i++) {
+                    row[first + i] = (int16_t)(units / kSpread[piece] + (i < units % kSpread[piece] ? 1 : 0));
+                }
+            }
+        }
+    }
+    // the side to move's half counts up and the other half down, 64 / NnueOutputDivisor is one unit
+    for (int i = 0; i <= kFirstNeuron[King]; i++) {
+        network->outputWeights[i] = 64;
+        network->outputWeights[NnueHidden + i] = -64;
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    uint32_t header[3] = { kNnueVersion, NnueInputs, NnueHidden };
+    file.write(kNnueMagic, sizeof(kNnueMagic));
+    file.write((const char *)header, sizeof(header));
+    file.write((const char *)network->featureWeights, sizeof(network->featureWeights));
+    file.write((const char *)network->featureBiases, sizeof(network->featureBiases));
+    file.write((const char *)network->outputWeights, sizeof(network->outputWeights));
+    file.write((const char *)&network->outputBias, sizeof(network->outputBias));
+    return (bool)file;
+}
+
+//
+// accumulator stack
+//
+
+NnueEvaluator::NnueEvaluator() : _stack(MaxPly), _ply(0), _evaluations(0)
+{
+}
+
+void NnueEvaluator::reset(const ChessPosition &position)
+{
+    _ply = 0;
+    Accumulator &root = _stack[0];
+    root.removedCount = root.addedCount = 0;
+    for (int side = White; side <= Black; side++) {
+        root.computed[side] = LoadedNetwork != nullptr;
+        root.refresh[side] = true;
+        if (LoadedNetwork) {
+            refreshHalf(position, side, root.values[side]);
+        }
+    }
+}
+
+void NnueEvaluator::push(const ChessPosition &position, const BitMove &move)
+{
+    Accumulator &next = _stack[++_ply];
+    int us = position.sideToMove();
+    int kind = move.kind();
+    next.computed[White] = next.computed[Black] = false;
+    next.refresh[White] = next.refresh[Black] = false;
+    next.removedCount = next.addedCount = 0;
+
+    int moving = pieceTag(us, move.piece);
+    next.removed[next.removedCount++] = { move.from, (uint8_t)moving };
+    int captureSquare = kind == MoveEnPassant ? (move.to ^ 8) : move.to;
+    int captured = position.pieceOn(captureSquare);
+    if (captured) {
+        next.removed[next.removedCount++] = { (uint8_t)captureSquare, (uint8_t)captured };
+    }
+    int arriving = kind == MovePromotion ? pieceTag(us, move.promotion()) : moving;
+    next.added[next.addedCount++] = { move.to, (uint8_t)arriving };
+    if (kind == MoveCastle) {
+        int rookFrom, rookTo;
+        castlingRookSquares(move.to, rookFrom, rookTo);
+        next.removed[next.removedCount++] = { (uint8_t)rookFrom, (uint8_t)pieceTag(us, Rook) };
+        next.added[next.addedCount++] = { (uint8_t)rookTo, (uint8_t)pieceTag(us, Rook) };
+    }
+    if (move.piece == King && kingBucket(us, move.from) != kingBucket(us, move.to)) {
+        next.refresh[us] = true;
+    }
+}
+
+void NnueEvaluator::pushNull()
+{
+    Accumulator &next = _stack[++_ply];
+    next.computed[White] = next.computed[Black] = false;
+    next.refresh[White] = next.refresh[Black] = false;
+    next.removedCount = next.addedCount = 0;
+}
+
+// bring one half of the top accumulator up to date from the nearest computed ancestor,
+// or rebuild it if the king changed bucket on the way
+void NnueEvaluator::update(const ChessPosition &position, int perspective)
+{
+    int base = _ply;
+    while (!_stack[base].computed[perspective] && !_stack[base].refresh[perspective]) {
+        base--;
+    }
+    if (!_stack[base].computed[perspective]) {
+        refreshHalf(position, perspective, _stack[_ply].values[perspective]);
+        _stack[_ply].computed[perspective] = true;
+        return;
+    }
+
+    int bucket = kingBucket(perspective, position.kingSquare(perspective));
+    for (int ply = base + 1; ply <= _ply; ply++) {
+        Accumulator &accumulator = _stack[ply];
+        int added[2], removed[2];
+        for (int i = 0; i < accumulator.addedCount; i++) {
+            added[i] = featureIndex(perspective, bucket, accumulator.added[i].square, accumulator.added[i].tag);
+        }
+        for (int i = 0; i < accumulator.removedCount; i++) {
+            removed[i] = featureIndex(perspective, bucket, accumulator.removed[i].square, accumulator.removed[i].tag);
+        }
+        addRows(accumulator.values[perspective], _stack[ply - 1].values[perspective],
+                added, accumulator.addedCount, removed, accumulator.removedCount);
+        accumulator.computed[perspective] = true;
+    }
+}
+
+int NnueEvaluator::evaluate(const ChessPosition &position)
+{
+    _evaluations++;
+    Accumulator &top = _stack[_ply];
+    for (int side = White; side <= Black; side++) {
+        if (!top.computed[side]) {
+            update(position, side);
+        }
+    }
+    int us = position.sideToMove();
+    return outputScore(top.values[us], top.values[us ^ 1]);
+}
+
+int NnueEvaluator::evaluateFromScratch(const ChessPosition &position)
+{
+    alignas(64) int16_t values[2][NnueHidden];
+    refreshHalf(position, White, values[White]);
+    refreshHalf(position, Black, values[Black]);
+    int us = position.sideToMove();
+    return outputScore(values[us], values[us ^ 1]);
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "ChessPosition.h"
+#include <string>
+#include <vector>
+
+//
+// efficiently updatable neural network evaluation
+//
+// the network sees the board twice, once from each side's point of view, flipped for
+// black so both halves look the same to it
+// its inputs are king bucketed piece-square features, (the viewer's king bucket, piece
+// color relative to the viewer, piece type, square), with 4 buckets by the side of the
+// board the king is on and whether it is still on its first two ranks
+// each half feeds a 128 wide int16 accumulator, a move only touches 2 to 4 features so the
+// accumulators are updated by adding and subtracting weight rows, and only once a position
+// is actually evaluated
+// the output layer takes both accumulators clipped to 0..127 as bytes, side to move first,
+// against int8 weights, so inference is integer only
+// the accumulator and output loops use AVX2 or SSE4.1 when the CPU has them, picked at
+// startup like the slider attack backend, with a plain C++ fallback
+//
+// network file, little endian:
+//   "CBNN", uint32 version, uint32 input count, uint32 hidden size
+//   int16 feature weights [inputs][hidden], int16 feature biases [hidden]
+//   int8 output weights [2 * hidden], int32 output bias
+//
+
+constexpr int NnueKingBuckets = 4;
+constexpr int NnueInputs = NnueKingBuckets * 2 * 6 * 64;
+constexpr int NnueHidden = 128;
+constexpr int NnueActivationMax = 127;
+// output sum per centipawn
+constexpr int NnueOutputDivisor = 16;
+
+enum NnueSimd
+{
+    NnueScalar,
+    NnueSse41,
+    NnueAvx2
+};
+
+// false with the reason in error if the file is missing or not a network of this shape,
+// a network loaded earlier stays in use
+bool loadNnue(const std::string &path, std::string &error);
+bool nnueLoaded();
+// writes a network that reproduces the material and piece-square part of the hand written
+// evaluation, a starting point for training and a known good file for the tests
+bool writePsqtNnue(const std::string &path);
+
+// the best the CPU supports, or less for testing, returns what is now in use
+NnueSimd setNnueSimd(NnueSimd limit);
+NnueSimd nnueSimd();
+const char *nnueSimdName();
+
+// one search thread's accumulators, one per ply of the line being searched
+class NnueEvaluator
+{
+public:
+    static constexpr int MaxPly = 256;
+
+    NnueEvaluator();
+
+    // start a new line at position
+    void reset(const ChessPosition &position);
+    // call before position.makeMove(move) and pop after unmakeMove
+    void push(const ChessPosition &position, const BitMove &move);
+    void pushNull();
+    void pop() { _ply--; }
+
+    // from the side to move's point of view, position must be the one at the top of the line
+    int evaluate(const ChessPosition &position);
+    // the same without the accumulators, for checking the incremental updates
+    static int evaluateFromScratch(const ChessPosition &position);
+
+    uint64_t evaluations() const { return _evaluations; }
+    void resetCounters() { _evaluations = 0; }
+
+private:
+    struct DirtyPiece
+    {
+        uint8_t square;
+        // gameTag encoding, see ChessPosition.h
+        uint8_t tag;
+    };
+
+    struct Accumulator
+    {
+        alignas(64) int16_t values[2][NnueHidden];
+        bool computed[2];
+        // the move took this side's king into another bucket, its half is rebuilt instead of updated
+        bool refresh[2];
+        // what the move into this ply changed, at most a moved piece and a capture or a castling rook
+        DirtyPiece removed[2];
+        DirtyPiece added[2];
+        int removedCount;
+        int addedCount;
+    };
+
+    void update(const ChessPosition &position, int perspective);
+
+    std::vector<Accumulator> _stack;
+    int _ply;
+    uint64_t _evaluations;
+};
@@ -0,0 +1,47 @@
+#include "ChessPacked.h"
+#include <cstring>
+
+bool packPosition(const ChessPosition &position, PackedPosition &packed)
+{
+    uint64_t occupied = position.occupied();
+    if (popCount(occupied) > 32) {
+        std::memset(&packed, 0xff, sizeof(packed));
+        return false;
+    }
+    std::memset(&packed, 0, sizeof(packed));
+    packed.occupancy = occupied;
+    int index = 0;
+    while (occupied) {
+        int tag = position.pieceOn(popLsb(occupied));
+        int code = pieceTypeOf(tag) | (pieceColorOf(tag) == Black ? 8 : 0);
+        packed.pieces[index >> 1] |= (uint8_t)(code << ((index & 1) * 4));
+        index++;
+    }
+    packed.sideAndCastling = (uint8_t)((position.sideToMove() << 4) | position.castlingRights());
+    packed.enPassantSquare = (uint8_t)position.enPassantSquare();
+    packed.halfmoveClock = (uint16_t)position.halfmoveClock();
+    packed.fullmoveNumber = (uint16_t)position.fullmoveNumber();
+    return true;
+}
+
+bool unpackPosition(const PackedPosition &packed, ChessPosition &position)
+{
+    if (popCount(packed.occupancy) > 32) {
+        return false;
+    }
+    position.clear();
+    uint64_t occupied = packed.occupancy;
+    int index = 0;
+    while (occupied) {
+        int square = popLsb(occupied);
+        int code = (packed.pieces[index >> 1] >> ((index & 1) * 4)) & 15;
+        position.putPiece(square, code & 8 ? Black : White, code & 7);
+        index++;
+    }
+    position.setSideToMove((packed.sideAndCastling >> 4) & 1);
+    position.setCastlingRights(packed.sideAndCastling & AllCastling);
+    position.setEnPassantSquare(packed.enPassantSquare);
+    position.setHalfmoveClock(packed.halfmoveClock);
+    position.setFullmoveNumber(packed.fullmoveNumber);
+    return true;
+}
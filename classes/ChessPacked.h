@@ -0,0 +1,36 @@
+#pragma once
+
+#include "ChessPosition.h"
+#include <cstdint>
+
+//
+// a position packed into 32 bytes, for game archives and turn histories that keep
+// millions of positions in memory
+//
+// the occupancy bitboard says which squares hold a piece, then one 4 bit code per
+// occupied square in a1 ... h8 order: the piece type, plus 8 for black
+// a legal position never has more than 32 pieces, so 16 bytes of codes always do
+// the rest is the state a FEN carries beyond the placement
+// fields are in native byte order, the same machine that packs them unpacks them
+//
+
+struct PackedPosition
+{
+    uint64_t occupancy;
+    uint8_t pieces[16];
+    // side to move in bit 4, castling rights in bits 0-3
+    uint8_t sideAndCastling;
+    uint8_t enPassantSquare;
+    uint16_t halfmoveClock;
+    uint16_t fullmoveNumber;
+    uint8_t reserved[2];
+};
+
+static_assert(sizeof(PackedPosition) == 32, "PackedPosition is meant to be 32 bytes");
+
+// false if the position has more than 32 pieces and cannot be packed, packed is then
+// filled with 0xff, an occupancy no packed position has, which unpackPosition refuses
+bool packPosition(const ChessPosition &position, PackedPosition &packed);
+// false and position left alone if packed is not a packed position
+// the undo history of the unpacked position is empty
+bool unpackPosition(const PackedPosition &packed, ChessPosition &position);
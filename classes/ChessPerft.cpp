@@ -0,0 +1,177 @@
+#include "ChessPerft.h"
+#include "ChessMoveGen.h"
+#include "ThreadPool.h"
+
+uint64_t perft(ChessPosition &position, int depth, bool bulkCount)
+{
+    if (depth == 0) {
+        return 1;
+    }
+
+    MoveList moves;
+    generateLegalMoves(position, moves);
+    if (bulkCount && depth == 1) {
+        return moves.size();
+    }
+
+    uint64_t nodes = 0;
+    for (const BitMove &move : moves) {
+        position.makeMove(move);
+        nodes += perft(position, depth - 1, bulkCount);
+        position.unmakeMove(move);
+    }
+    return nodes;
+}
+
+std::vector<PerftDivideEntry> perftDivide(ChessPosition &position, int depth, bool bulkCount)
+{
+    std::vector<PerftDivideEntry> entries;
+    if (depth < 1) {
+        return entries;
+    }
+
+    MoveList moves;
+    generateLegalMoves(position, moves);
+    for (const BitMove &move : moves) {
+        position.makeMove(move);
+        entries.push_back({ move, perft(position, depth - 1, bulkCount) });
+        position.unmakeMove(move);
+    }
+    return entries;
+}
+
+PerftHashTable::PerftHashTable(size_t megabytes)
+{
+    // round down to a power of two so the index is a mask
+    size_t count = 1;
+    while (count * 2 * sizeof(Entry) <= megabytes * 1024 * 1024) {
+        count *= 2;
+    }
+    _entries = std::make_unique<Entry[]>(count);
+    _mask = count - 1;
+    for (size_t i = 0; i < count; i++) {
+        _entries[i].check.store(0, std::memory_order_relaxed);
+        _entries[i].data.store(0, std::memory_order_relaxed);
+    }
+}
+
+bool PerftHashTable::probe(uint64_t key, int depth, uint64_t &nodes) const
+{
+    const Entry &entry = _entries[index(key, depth)];
+    uint64_t data = entry.data.load(std::memory_order_relaxed);
+    uint64_t check = entry.check.load(std::memory_order_relaxed);
+    if ((check ^ data) != key || (int)(data & 0xff) != depth) {
+        return false;
+    }
+    nodes = data >> 8;
+    return true;
+}
+
+void PerftHashTable::store(uint64_t key, int depth, uint64_t nodes)
+{
+    Entry &entry = _entries[index(key, depth)];
+    uint64_t data = (nodes << 8) | (uint64_t)depth;
+    entry.data.store(data, std::memory_order_relaxed);
+    entry.check.store(key ^ data, std::memory_order_relaxed);
+}
+
+static uint64_t perftHashed(ChessPosition &position, int depth, bool bulkCount, PerftHashTable *table)
+{
+    if (depth == 0) {
+        return 1;
+    }
+
+    MoveList moves;
+    generateLegalMoves(position, moves);
+    if (bulkCount && depth == 1) {
+        return moves.size();
+    }
+
+    uint64_t key = 0;
+    if (table && depth >= 2) {
+        key = position.key();
+        uint64_t nodes;
+        if (table->probe(key, depth, nodes)) {
+            return nodes;
+        }
+    }
+
+    uint64_t nodes = 0;
+    for (const BitMove &move : moves) {
+        position.makeMove(move);
+        nodes += perftHashed(position, depth - 1, bulkCount, table);
+        position.unmakeMove(move);
+    }
+
+    if (table && depth >= 2) {
+        table->store(key, depth, nodes);
+    }
+    return nodes;
+}
+
+std::vector<PerftDivideEntry> perftParallel(const ChessPosition &position, int depth, const PerftOptions &options)
+{
+    std::vector<PerftDivideEntry> entries;
+    if (depth < 1) {
+        return entries;
+    }
+
+    std::unique_ptr<PerftHashTable> table;
+    if (options.hashMegabytes > 0) {
+        table = std::make_unique<PerftHashTable>(options.hashMegabytes);
+    }
+
+    MoveList rootMoves;
+    generateLegalMoves(position, rootMoves);
+    std::vector<std::atomic<uint64_t>> counts(rootMoves.size());
+    for (auto &count : counts) {
+        count.store(0);
+    }
+
+    ThreadPool pool(options.threads);
+    for (int i = 0; i < rootMoves.size(); i++) {
+        BitMove rootMove = rootMoves[i];
+        if (options.splitDepth >= 2 && depth >= 3) {
+            // one task per reply, much better balanced than one task per root move
+            ChessPosition child = position;
+            child.makeMove(rootMove);
+            MoveList replies;
+            generateLegalMoves(child, replies);
+            for (const BitMove &reply : replies) {
+                pool.submit([&, i, rootMove, reply] {
+                    ChessPosition local = position;
+                    local.makeMove(rootMove);
+                    local.makeMove(reply);
+                    counts[i].fetch_add(perftHashed(local, depth - 2, options.bulkCount, table.get()));
+                });
+            }
+        } else {
+            pool.submit([&, i, rootMove] {
+                ChessPosition local = position;
+                local.makeMove(rootMove);
+                counts[i].fetch_add(perftHashed(local, depth - 1, options.bulkCount, table.get()));
+            });
+        }
+    }
+    pool.wait();
+
+    for (int i = 0; i < rootMoves.size(); i++) {
+        entries.push_back({ rootMoves[i], counts[i].load() });
+    }
+    return entries;
+}
+
+//
+// standard positions from the chess programming wiki perft results page
+//
+const PerftSuiteEntry kPerftSuite[] = {
+    { "startpos",   "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",                 5, 4865609ULL },
+    { "kiwipete",   "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",     4, 4085603ULL },
+    { "position3",  "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",                                6, 11030083ULL },
+    { "position4",  "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",         5, 15833292ULL },
+    { "position4b", "r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1",         5, 15833292ULL },
+    { "position5",  "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",                4, 2103487ULL },
+    { "position6",  "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 4, 3894594ULL },
+};
+
+const int kPerftSuiteSize = sizeof(kPerftSuite) / sizeof(kPerftSuite[0]);
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "ChessPosition.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+//
+// perft walks the legal move tree to a fixed depth and counts the leaves
+// it is the standard way to validate a move generator and to measure its speed
+//
+
+// with bulk counting the last ply is counted from the size of the move list instead of being played
+uint64_t perft(ChessPosition &position, int depth, bool bulkCount = true);
+
+struct PerftDivideEntry
+{
+    BitMove move;
+    uint64_t nodes;
+};
+
+// perft split by root move, for tracking down generator bugs against a reference engine
+std::vector<PerftDivideEntry> perftDivide(ChessPosition &position, int depth, bool bulkCount = true);
+
+//
+// shared perft hash table keyed by zobrist key and depth
+// entries are two relaxed atomics, the first holds key ^ data so a torn read from
+// two racing writers fails the check instead of returning a wrong count
+//
+class PerftHashTable
+{
+public:
+    explicit PerftHashTable(size_t megabytes);
+
+    bool probe(uint64_t key, int depth, uint64_t &nodes) const;
+    void store(uint64_t key, int depth, uint64_t nodes);
+
+private:
+    struct Entry
+    {
+        std::atomic<uint64_t> check;
+        std::atomic<uint64_t> data;
+    };
+
+    size_t index(uint64_t key, int depth) const { return (key ^ (depth * 0x9E3779B97F4A7C15ULL)) & _mask; }
+
+    std::unique_ptr<Entry[]> _entries;
+    size_t _mask;
+};
+
+struct PerftOptions
+{
+    int threads = 1;
+    // 1 splits the root moves across threads, 2 splits every reply to every root move
+    int splitDepth = 1;
+    // 0 disables the hash table
+    size_t hashMegabytes = 0;
+    bool bulkCount = true;
+};
+
+// perft divide run on a work stealing thread pool, counts match the serial perftDivide
+std::vector<PerftDivideEntry> perftParallel(const ChessPosition &position, int depth, const PerftOptions &options);
+
+// a well known position with published node counts
+struct PerftSuiteEntry
+{
+    const char *name;
+    const char *fen;
+    int depth;
+    uint64_t nodes;
+};
+
+extern const PerftSuiteEntry kPerftSuite[];
+extern const int kPerftSuiteSize;
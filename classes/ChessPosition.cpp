@@ -0,0 +1,329 @@
+#include "ChessPosition.h"
+#include "ChessFen.h"
+#include "ChessMoveGen.h"
+#include "ChessZobrist.h"
+#include <algorithm>
+#include <cstring>
+
+// castling rights that survive a move touching each square
+static const uint8_t kCastlingMask[64] = {
+    (uint8_t)~WhiteQueenSide, 15, 15, 15, (uint8_t)~(WhiteKingSide | WhiteQueenSide), 15, 15, (uint8_t)~WhiteKingSide,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    (uint8_t)~BlackQueenSide, 15, 15, 15, (uint8_t)~(BlackKingSide | BlackQueenSide), 15, 15, (uint8_t)~BlackKingSide,
+};
+
+ChessPosition::ChessPosition()
+{
+    clear();
+}
+
+void ChessPosition::clear()
+{
+    std::memset(_pieces, 0, sizeof(_pieces));
+    std::memset(_occupancy, 0, sizeof(_occupancy));
+    std::memset(_board, 0, sizeof(_board));
+    _sideToMove = White;
+    _castlingRights = NoCastling;
+    _enPassantSquare = NoSquare;
+    _halfmoveClock = 0;
+    _fullmoveNumber = 1;
+    _key = kZobrist.castling[NoCastling];
+    _pawnKey = 0ULL;
+    _pieceSquare = PhaseScore{ 0, 0 };
+    _phase = 0;
+    _historyPly = 0;
+}
+
+void ChessPosition::setSideToMove(int color)
+{
+    if (color != _sideToMove) {
+        _key ^= kZobrist.sideToMove;
+    }
+    _sideToMove = color;
+}
+
+void ChessPosition::setCastlingRights(int rights)
+{
+    _key ^= kZobrist.castling[_castlingRights] ^ kZobrist.castling[rights];
+    _castlingRights = rights;
+}
+
+void ChessPosition::setEnPassantSquare(int square)
+{
+    if (_enPassantSquare != NoSquare) {
+        _key ^= kZobrist.enPassantFile[fileOf(_enPassantSquare)];
+    }
+    if (square != NoSquare) {
+        _key ^= kZobrist.enPassantFile[fileOf(square)];
+    }
+    _enPassantSquare = square;
+}
+
+void ChessPosition::putPiece(int square, int color, int piece)
+{
+    uint64_t bit = 1ULL << square;
+    _pieces[color][piece] |= bit;
+    _occupancy[color] |= bit;
+    _board[square] = (uint8_t)pieceTag(color, piece);
+    _key ^= kZobrist.pieces[color][piece][square];
+    if (piece == Pawn) {
+        _pawnKey ^= kZobrist.pieces[color][Pawn][square];
+    }
+    _pieceSquare += kPieceSquare.values[color][piece][square];
+    _phase += kPhaseWeight[piece];
+}
+
+void ChessPosition::removePiece(int square)
+{
+    int tag = _board[square];
+    if (!tag) {
+        return;
+    }
+    uint64_t bit = 1ULL << square;
+    int color = pieceColorOf(tag);
+    int piece = pieceTypeOf(tag);
+    _pieces[color][piece] &= ~bit;
+    _occupancy[color] &= ~bit;
+    _board[square] = 0;
+    _key ^= kZobrist.pieces[color][piece][square];
+    if (piece == Pawn) {
+        _pawnKey ^= kZobrist.pieces[color][Pawn][square];
+    }
+    _pieceSquare -= kPieceSquare.values[color][piece][square];
+    _phase -= kPhaseWeight[piece];
+}
+
+void ChessPosition::movePiece(int from, int to)
+{
+    int tag = _board[from];
+    uint64_t fromTo = (1ULL << from) | (1ULL << to);
+    int color = pieceColorOf(tag);
+    int piece = pieceTypeOf(tag);
+    _pieces[color][piece] ^= fromTo;
+    _occupancy[color] ^= fromTo;
+    _board[from] = 0;
+    _board[to] = (uint8_t)tag;
+    uint64_t keyChange = kZobrist.pieces[color][piece][from] ^ kZobrist.pieces[color][piece][to];
+    _key ^= keyChange;
+    if (piece == Pawn) {
+        _pawnKey ^= keyChange;
+    }
+    _pieceSquare += kPieceSquare.values[color][piece][to] - kPieceSquare.values[color][piece][from];
+}
+
+PhaseScore ChessPosition::computePieceSquare() const
+{
+    PhaseScore score{ 0, 0 };
+    for (int square = 0; square < 64; square++) {
+        int tag = _board[square];
+        if (tag) {
+            score += kPieceSquare.values[pieceColorOf(tag)][pieceTypeOf(tag)][square];
+        }
+    }
+    return score;
+}
+
+int ChessPosition::computePhase() const
+{
+    int phase = 0;
+    for (int piece = Knight; piece <= Queen; piece++) {
+        phase += kPhaseWeight[piece] * popCount(_pieces[White][piece] | _pieces[Black][piece]);
+    }
+    return phase;
+}
+
+uint64_t ChessPosition::attackersTo(int square, uint64_t occupied) const
+{
+    uint64_t rookLike = _pieces[White][Rook] | _pieces[Black][Rook] | _pieces[White][Queen] | _pieces[Black][Queen];
+    uint64_t bishopLike = _pieces[White][Bishop] | _pieces[Black][Bishop] | _pieces[White][Queen] | _pieces[Black][Queen];
+    return (pawnAttacks(Black, square) & _pieces[White][Pawn])
+         | (pawnAttacks(White, square) & _pieces[Black][Pawn])
+         | (knightAttacks(square) & (_pieces[White][Knight] | _pieces[Black][Knight]))
+         | (kingAttacks(square) & (_pieces[White][King] | _pieces[Black][King]))
+         | (getRookAttacks(square, occupied) & rookLike)
+         | (getBishopAttacks(square, occupied) & bishopLike);
+}
+
+uint64_t ChessPosition::computeKey() const
+{
+    uint64_t key = 0ULL;
+    for (int square = 0; square < 64; square++) {
+        int tag = _board[square];
+        if (tag) {
+            key ^= kZobrist.pieces[pieceColorOf(tag)][pieceTypeOf(tag)][square];
+        }
+    }
+    if (_sideToMove == Black) {
+        key ^= kZobrist.sideToMove;
+    }
+    key ^= kZobrist.castling[_castlingRights];
+    if (_enPassantSquare != NoSquare) {
+        key ^= kZobrist.enPassantFile[fileOf(_enPassantSquare)];
+    }
+    return key;
+}
+
+uint64_t ChessPosition::computePawnKey() const
+{
+    uint64_t key = 0ULL;
+    for (int color = White; color <= Black; color++) {
+        uint64_t pawns = _pieces[color][Pawn];
+        while (pawns) {
+            key ^= kZobrist.pieces[color][Pawn][popLsb(pawns)];
+        }
+    }
+    return key;
+}
+
+bool ChessPosition::setFromFEN(const std::string &fen)
+{
+    return parseFEN(fen, *this).ok();
+}
+
+void ChessPosition::makeMove(const BitMove &move)
+{
+    _keyHistory[_historyPly] = _key;
+    UndoState &undo = _history[_historyPly++];
+    undo.pawnKey = _pawnKey;
+    undo.castlingRights = _castlingRights;
+    undo.enPassantSquare = _enPassantSquare;
+    undo.halfmoveClock = _halfmoveClock;
+
+    int us = _sideToMove;
+    int from = move.from;
+    int to = move.to;
+    int kind = move.kind();
+
+    // take off the captured piece first so movePiece never lands on an occupied square
+    int captureSquare = (kind == MoveEnPassant) ? (to ^ 8) : to;
+    undo.captured = _board[captureSquare];
+    if (undo.captured) {
+        removePiece(captureSquare);
+    }
+
+    movePiece(from, to);
+
+    if (kind == MovePromotion) {
+        removePiece(to);
+        putPiece(to, us, move.promotion());
+    } else if (kind == MoveCastle) {
+        int rookFrom, rookTo;
+        castlingRookSquares(to, rookFrom, rookTo);
+        movePiece(rookFrom, rookTo);
+    }
+
+    if (_enPassantSquare != NoSquare) {
+        _key ^= kZobrist.enPassantFile[fileOf(_enPassantSquare)];
+    }
+    _enPassantSquare = (kind == MoveDoublePush) ? (uint8_t)((from + to) / 2) : (uint8_t)NoSquare;
+    if (_enPassantSquare != NoSquare) {
+        _key ^= kZobrist.enPassantFile[fileOf(_enPassantSquare)];
+    }
+    _key ^= kZobrist.castling[_castlingRights];
+    _castlingRights &= kCastlingMask[from] & kCastlingMask[to];
+    _key ^= kZobrist.castling[_castlingRights];
+    _key ^= kZobrist.sideToMove;
+    _halfmoveClock = (undo.captured || move.piece == Pawn) ? 0 : _halfmoveClock + 1;
+    if (us == Black) {
+        _fullmoveNumber++;
+    }
+    _sideToMove = us ^ 1;
+}
+
+void ChessPosition::unmakeMove(const BitMove &move)
+{
+    const UndoState &undo = _history[--_historyPly];
+
+    _sideToMove ^= 1;
+    int us = _sideToMove;
+    int from = move.from;
+    int to = move.to;
+    int kind = move.kind();
+
+    if (kind == MovePromotion) {
+        removePiece(to);
+        putPiece(to, us, Pawn);
+    } else if (kind == MoveCastle) {
+        int rookFrom, rookTo;
+        castlingRookSquares(to, rookFrom, rookTo);
+        movePiece(rookTo, rookFrom);
+    }
+
+    movePiece(to, from);
+
+    if (undo.captured) {
+        int captureSquare = (kind == MoveEnPassant) ? (to ^ 8) : to;
+        putPiece(captureSquare, pieceColorOf(undo.captured), pieceTypeOf(undo.captured));
+    }
+
+    if (us == Black) {
+        _fullmoveNumber--;
+    }
+    _castlingRights = undo.castlingRights;
+    _enPassantSquare = undo.enPassantSquare;
+    _halfmoveClock = undo.halfmoveClock;
+    // restoring the saved keys also covers side, castling and en passant
+    _key = _keyHistory[_historyPly];
+    _pawnKey = undo.pawnKey;
+}
+
+void ChessPosition::makeNullMove()
+{
+    _keyHistory[_historyPly] = _key;
+    UndoState &undo = _history[_historyPly++];
+    undo.pawnKey = _pawnKey;
+    undo.castlingRights = _castlingRights;
+    undo.enPassantSquare = _enPassantSquare;
+    undo.halfmoveClock = _halfmoveClock;
+    undo.captured = 0;
+
+    if (_enPassantSquare != NoSquare) {
+        _key ^= kZobrist.enPassantFile[fileOf(_enPassantSquare)];
+        _enPassantSquare = NoSquare;
+    }
+    _key ^= kZobrist.sideToMove;
+    _halfmoveClock++;
+    _sideToMove ^= 1;
+}
+
+void ChessPosition::unmakeNullMove()
+{
+    const UndoState &undo = _history[--_historyPly];
+    _sideToMove ^= 1;
+    _enPassantSquare = undo.enPassantSquare;
+    _halfmoveClock = undo.halfmoveClock;
+    _key = _keyHistory[_historyPly];
+}
+
+void ChessPosition::makeRoomInHistory(int plies)
+{
+    if (_historyPly + plies < MaxGamePly) {
+        return;
+    }
+    int keep = std::max(0, std::min({ (int)_halfmoveClock, _historyPly, MaxGamePly - 1 - plies }));
+    int first = _historyPly - keep;
+    std::memmove(_history, _history + first, keep * sizeof(UndoState));
+    std::memmove(_keyHistory, _keyHistory + first, keep * sizeof(uint64_t));
+    _historyPly = keep;
+}
+
+bool ChessPosition::isRepetition(int rootPly) const
+{
+    // a position can first repeat 4 plies later, and only with the same side to move
+    int oldest = std::max(0, _historyPly - _halfmoveClock);
+    bool seenBeforeRoot = false;
+    for (int ply = _historyPly - 4; ply >= oldest; ply -= 2) {
+        if (_keyHistory[ply] == _key) {
+            if (ply >= rootPly || seenBeforeRoot) {
+                return true;
+            }
+            seenBeforeRoot = true;
+        }
+    }
+    return false;
+}
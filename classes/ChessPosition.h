@@ -0,0 +1,170 @@
+#pragma once
+
+#include "Bitboard.h"
+#include "ChessPsqt.h"
+#include "ChessZobrist.h"
+#include <cstdint>
+#include <string>
+
+//
+// compact bitboard representation of a chess position
+// this is the single source of truth for the chess game, the Grid and its Bits
+// are only a mirror of it for rendering
+//
+// squares are numbered a1 = 0 ... h8 = 63, the same as ChessSquare::getSquareIndex()
+// pieces on the mailbox board use the Bit gameTag encoding: piece type for white,
+// piece type + 128 for black, 0 for an empty square
+//
+
+enum ChessColor
+{
+    White = 0,
+    Black = 1
+};
+
+enum CastlingRights
+{
+    NoCastling = 0,
+    WhiteKingSide = 1,
+    WhiteQueenSide = 2,
+    BlackKingSide = 4,
+    BlackQueenSide = 8,
+    AllCastling = 15
+};
+
+constexpr int NoSquare = 64;
+constexpr int BlackPieceTag = 128;
+
+inline int squareOf(int file, int rank) { return rank * 8 + file; }
+inline int fileOf(int square) { return square & 7; }
+inline int rankOf(int square) { return square >> 3; }
+
+inline int pieceTag(int color, int piece) { return color == Black ? piece + BlackPieceTag : piece; }
+inline int pieceTypeOf(int tag) { return tag & (BlackPieceTag - 1); }
+inline int pieceColorOf(int tag) { return tag >= BlackPieceTag ? Black : White; }
+
+// rook squares for a castling move, indexed by the king's destination
+inline void castlingRookSquares(int kingTo, int &rookFrom, int &rookTo)
+{
+    bool kingSide = fileOf(kingTo) == 6;
+    int backRank = kingTo & ~7;
+    rookFrom = backRank + (kingSide ? 7 : 0);
+    rookTo = backRank + (kingSide ? 5 : 3);
+}
+
+//
+// everything makeMove overwrites that unmakeMove cannot recompute, apart from the zobrist
+// key which goes to its own contiguous history for repetition checks
+//
+struct UndoState
+{
+    uint64_t pawnKey;
+    uint8_t captured;
+    uint8_t castlingRights;
+    uint8_t enPassantSquare;
+    uint16_t halfmoveClock;
+};
+
+class ChessPosition
+{
+public:
+    // depth of the undo stack, enough for any real game plus a search on top of it
+    static constexpr int MaxGamePly = 1024;
+
+    ChessPosition();
+
+    // empty the board and reset all state
+    void clear();
+    // load a position from a FEN string, returns false if it is malformed, see ChessFen.h for the details
+    bool setFromFEN(const std::string &fen);
+
+    // bitboard access
+    uint64_t pieces(int color, int piece) const { return _pieces[color][piece]; }
+    uint64_t occupancy(int color) const { return _occupancy[color]; }
+    uint64_t occupied() const { return _occupancy[White] | _occupancy[Black]; }
+    uint64_t empty() const { return ~occupied(); }
+
+    // mailbox access, returns a gameTag style piece code or 0
+    int pieceOn(int square) const { return _board[square]; }
+
+    int sideToMove() const { return _sideToMove; }
+    int castlingRights() const { return _castlingRights; }
+    int enPassantSquare() const { return _enPassantSquare; }
+    int halfmoveClock() const { return _halfmoveClock; }
+    int fullmoveNumber() const { return _fullmoveNumber; }
+
+    // zobrist keys built from scratch, see ChessZobrist.h
+    uint64_t computeKey() const;
+    uint64_t computePawnKey() const;
+
+    int kingSquare(int color) const { return lsb(_pieces[color][King]); }
+    // every piece of either color attacking square given the occupancy
+    uint64_t attackersTo(int square, uint64_t occupied) const;
+    bool isSquareAttacked(int square, int byColor) const { return (attackersTo(square, occupied()) & _occupancy[byColor]) != 0; }
+    bool inCheck() const { return isSquareAttacked(kingSquare(_sideToMove), _sideToMove ^ 1); }
+
+    // material plus piece-square values, white minus black, and the game phase,
+    // kept up to date by every board update, see ChessPsqt.h
+    const PhaseScore &pieceSquare() const { return _pieceSquare; }
+    int phase() const { return _phase; }
+    // the same built from scratch
+    PhaseScore computePieceSquare() const;
+    int computePhase() const;
+
+    // zobrist keys, kept up to date by every board update
+    uint64_t key() const { return _key; }
+    // pawns only, for caching pawn structure evaluation
+    uint64_t pawnKey() const { return _pawnKey; }
+
+    void setSideToMove(int color);
+    void setCastlingRights(int rights);
+    void setEnPassantSquare(int square);
+    void setHalfmoveClock(int clock) { _halfmoveClock = clock; }
+    void setFullmoveNumber(int number) { _fullmoveNumber = number; }
+
+    // incremental board updates, these keep bitboards, occupancy and the mailbox in step
+    void putPiece(int square, int color, int piece);
+    void removePiece(int square);
+    void movePiece(int from, int to);
+
+    // apply and take back a move, both are O(1) and never allocate
+    // the move must be pseudo-legal for the side to move
+    void makeMove(const BitMove &move);
+    void unmakeMove(const BitMove &move);
+    // pass the turn, only the side to move and en passant change, for null move pruning
+    void makeNullMove();
+    void unmakeNullMove();
+
+    int historyPly() const { return _historyPly; }
+    // make sure at least plies more moves fit on the undo stack, when they do not the moves
+    // older than the last capture or pawn move are dropped, repetitions and the fifty move
+    // rule never look further back, and those moves can no longer be taken back
+    void makeRoomInHistory(int plies);
+
+    // draw by repetition, the current position already occurred with the same side to move
+    // a repeat of a position after rootPly is a draw at once, the side that allowed it could
+    // just as well repeat again, a position before rootPly needs its third occurrence
+    // only looks back to the last capture or pawn move, O(halfmove clock)
+    bool isRepetition(int rootPly) const;
+    // fifty moves by each side without a capture or pawn move, a mate on the last one still wins
+    bool isFiftyMoveDraw() const { return _halfmoveClock >= 100; }
+
+private:
+    uint64_t _pieces[2][7];
+    uint64_t _occupancy[2];
+    uint8_t _board[64];
+    uint8_t _sideToMove;
+    uint8_t _castlingRights;
+    uint8_t _enPassantSquare;
+    uint16_t _halfmoveClock;
+    uint16_t _fullmoveNumber;
+    uint64_t _key;
+    uint64_t _pawnKey;
+    PhaseScore _pieceSquare;
+    int _phase;
+
+    UndoState _history[MaxGamePly];
+    // the key before each move on the undo stack
+    uint64_t _keyHistory[MaxGamePly];
+    int _historyPly;
+};
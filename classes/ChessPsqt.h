@@ -0,0 +1,141 @@
+#pragma once
+
+#include "Bitboard.h"
+
+//
+// material and piece-square values for the chess evaluation
+//
+// every term has a middlegame and an endgame value, the evaluation blends them by the
+// game phase, the non-pawn material left on the board
+// ChessPosition keeps the sum of kPieceSquare over all pieces and the phase up to date
+// in putPiece, removePiece and movePiece, so make and unmake maintain them for free and
+// the evaluation reads them in O(1)
+//
+
+struct PhaseScore
+{
+    int mg;
+    int eg;
+
+    constexpr PhaseScore operator+(const PhaseScore &other) const { return { mg + other.mg, eg + other.eg }; }
+    constexpr PhaseScore operator-(const PhaseScore &other) const { return { mg - other.mg, eg - other.eg }; }
+    constexpr PhaseScore operator-() const { return { -mg, -eg }; }
+    constexpr PhaseScore operator*(int factor) const { return { mg * factor, eg * factor }; }
+    PhaseScore &operator+=(const PhaseScore &other) { mg += other.mg; eg += other.eg; return *this; }
+    PhaseScore &operator-=(const PhaseScore &other) { mg -= other.mg; eg -= other.eg; return *this; }
+    constexpr bool operator==(const PhaseScore &other) const { return mg == other.mg && eg == other.eg; }
+};
+
+// phase contributed by each piece type, 24 with all pieces on the board
+constexpr int kPhaseWeight[7] = { 0, 0, 1, 1, 2, 4, 0 };
+constexpr int MaxPhase = 24;
+
+constexpr PhaseScore kMaterial[7] = { { 0, 0 }, { 80, 100 }, { 320, 300 }, { 330, 320 }, { 480, 540 }, { 950, 1000 }, { 0, 0 } };
+
+// tables are laid out as seen from white, rank 8 on the first row
+constexpr int kPsqtPawnMg[64] = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+     40,  50,  50,  60,  60,  50,  50,  40,
+     10,  15,  20,  30,  30,  20,  15,  10,
+      0,   5,  10,  25,  25,  10,   5,   0,
+     -5,   0,   5,  20,  20,   5,   0,  -5,
+     -5,  -5,   0,   5,   5,   0,  -5,  -5,
+     -5,   0,   0, -15, -15,   0,   0,  -5,
+      0,   0,   0,   0,   0,   0,   0,   0,
+};
+constexpr int kPsqtPawnEg[64] = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+     80,  80,  80,  80,  80,  80,  80,  80,
+     50,  50,  50,  50,  50,  50,  50,  50,
+     30,  30,  30,  30,  30,  30,  30,  30,
+     15,  15,  15,  15,  15,  15,  15,  15,
+      5,   5,   5,   5,   5,   5,   5,   5,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+};
+constexpr int kPsqtKnight[64] = {
+    -50, -40, -30, -30, -30, -30, -40, -50,
+    -40, -20,   0,   0,   0,   0, -20, -40,
+    -30,   0,  10,  15,  15,  10,   0, -30,
+    -30,   5,  15,  20,  20,  15,   5, -30,
+    -30,   0,  15,  20,  20,  15,   0, -30,
+    -30,   5,  10,  15,  15,  10,   5, -30,
+    -40, -20,   0,   5,   5,   0, -20, -40,
+    -50, -40, -30, -30, -30, -30, -40, -50,
+};
+constexpr int kPsqtBishop[64] = {
+    -20, -10, -10, -10, -10, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,  10,  10,   5,   0, -10,
+    -10,   5,   5,  10,  10,   5,   5, -10,
+    -10,   0,  10,  10,  10,  10,   0, -10,
+    -10,  10,  10,  10,  10,  10,  10, -10,
+    -10,   5,   0,   0,   0,   0,   5, -10,
+    -20, -10, -10, -10, -10, -10, -10, -20,
+};
+constexpr int kPsqtRook[64] = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+      5,  10,  10,  10,  10,  10,  10,   5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+      0,   0,   0,   5,   5,   0,   0,   0,
+};
+constexpr int kPsqtQueen[64] = {
+    -20, -10, -10,  -5,  -5, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,   5,   5,   5,   0, -10,
+     -5,   0,   5,   5,   5,   5,   0,  -5,
+      0,   0,   5,   5,   5,   5,   0,  -5,
+    -10,   5,   5,   5,   5,   5,   0, -10,
+    -10,   0,   5,   0,   0,   0,   0, -10,
+    -20, -10, -10,  -5,  -5, -10, -10, -20,
+};
+constexpr int kPsqtKingMg[64] = {
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -20, -30, -30, -40, -40, -30, -30, -20,
+    -10, -20, -20, -20, -20, -20, -20, -10,
+     20,  20,   0,   0,   0,   0,  20,  20,
+     20,  30,  10,   0,   0,  10,  30,  20,
+};
+constexpr int kPsqtKingEg[64] = {
+    -50, -40, -30, -20, -20, -30, -40, -50,
+    -30, -20, -10,   0,   0, -10, -20, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -30,   0,   0,   0,   0, -30, -30,
+    -50, -30, -30, -30, -30, -30, -30, -50,
+};
+
+constexpr const int *kPsqtMg[7] = { nullptr, kPsqtPawnMg, kPsqtKnight, kPsqtBishop, kPsqtRook, kPsqtQueen, kPsqtKingMg };
+constexpr const int *kPsqtEg[7] = { nullptr, kPsqtPawnEg, kPsqtKnight, kPsqtBishop, kPsqtRook, kPsqtQueen, kPsqtKingEg };
+
+struct PieceSquareTable
+{
+    PhaseScore values[2][7][64];
+};
+
+// white scores count up and black scores count down, black reads the tables from its own side
+constexpr PieceSquareTable makePieceSquareTable()
+{
+    PieceSquareTable table{};
+    for (int piece = 1; piece < 7; piece++) {
+        for (int square = 0; square < 64; square++) {
+            PhaseScore white = kMaterial[piece] + PhaseScore{ kPsqtMg[piece][square ^ 56], kPsqtEg[piece][square ^ 56] };
+            PhaseScore black = kMaterial[piece] + PhaseScore{ kPsqtMg[piece][square], kPsqtEg[piece][square] };
+            table.values[0][piece][square] = white;
+            table.values[1][piece][square] = -black;
+        }
+    }
+    return table;
+}
+
+// material plus piece-square value by color, piece and square, white minus black
+inline constexpr PieceSquareTable kPieceSquare = makePieceSquareTable();
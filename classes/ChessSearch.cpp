@@ -0,0 +1,638 @@
+#include "ChessSearch.h"
+#include "ChessEval.h"
+#include "ChessMovePicker.h"
+#include "ChessSee.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+// mate scores are stored relative to the node, not the root, so they stay valid
+// when the same position turns up at a different distance from the root
+static int scoreToTable(int score, int ply)
+{
+    if (score >= ScoreMateInMaxPly) {
+        return score + ply;
+    }
+    if (score <= -ScoreMateInMaxPly) {
+        return score - ply;
+    }
+    return score;
+}
+
+static int scoreFromTable(int score, int ply)
+{
+    if (score >= ScoreMateInMaxPly) {
+        return score - ply;
+    }
+    if (score <= -ScoreMateInMaxPly) {
+        return score + ply;
+    }
+    return score;
+}
+
+// depth skew for helper threads, helper i skips the depths where
+// ((depth + phase) / size) is odd, so neighbouring helpers are out of step
+static constexpr int kSkipPatterns = 20;
+static constexpr int kSkipSize[kSkipPatterns] = { 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4 };
+static constexpr int kSkipPhase[kSkipPatterns] = { 0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7 };
+
+// late move reductions by depth and move number, filled in once
+struct ReductionTable
+{
+    int reductions[64][64];
+
+    ReductionTable()
+    {
+        for (int depth = 0; depth < 64; depth++) {
+            for (int moves = 0; moves < 64; moves++) {
+                reductions[depth][moves] = (depth && moves) ? (int)(0.75 + std::log(depth) * std::log(moves) / 2.25) : 0;
+            }
+        }
+    }
+};
+
+static const ReductionTable kReductions;
+
+static int lateMoveReduction(int depth, int moveCount)
+{
+    return kReductions.reductions[std::min(depth, 63)][std::min(moveCount, 63)];
+}
+
+// beyond the captured piece, the most a capture can swing the static evaluation
+static constexpr int kDeltaMargin = 200;
+
+ChessSearch::ChessSearch(TranspositionTable &table)
+    : onIteration(printInfo), _table(table), _stopRequested(false), _sharedStop(nullptr), _stopped(false), _pondering(false), _rootSide(0), _rootPly(0), _nodes(0), _publishedNodes(0), _threadIndex(0), _selDepth(0), _useNnue(false), _excludedRootCount(0)
+{
+    _history.clear();
+}
+
+void ChessSearch::printInfo(const SearchInfo &info)
+{
+    std::cout << "info depth " << info.depth << " seldepth " << info.selDepth;
+    if (info.multiPV) {
+        std::cout << " multipv " << info.multiPV;
+    }
+    if (info.score >= ScoreMateInMaxPly) {
+        std::cout << " score mate " << (ScoreMate - info.score + 1) / 2;
+    } else if (info.score <= -ScoreMateInMaxPly) {
+        std::cout << " score mate " << -(ScoreMate + info.score) / 2;
+    } else {
+        std::cout << " score cp " << info.score;
+    }
+    std::cout << " nodes " << info.nodes << " nps " << info.nps << " hashfull " << info.hashfull
+              << " time " << info.timeMs << " pv";
+    for (const BitMove &move : info.pv) {
+        std::cout << " " << moveToString(move);
+    }
+    std::cout << std::endl;
+}
+
+bool ChessSearch::shouldStop()
+{
+    // polled every 1024 nodes so the atomic load stays off the hot path
+    if ((_nodes & 1023) == 0) {
+        _publishedNodes.store(_nodes, std::memory_order_relaxed);
+        if (_stopRequested.load(std::memory_order_relaxed)
+            || (_sharedStop && _sharedStop->load(std::memory_order_relaxed))
+            || (_limits.cancel && _limits.cancel->load(std::memory_order_relaxed))
+            || (_limits.nodes && _nodes >= _limits.nodes)
+            || _timeManager.hardLimitReached()) {
+            _stopped = true;
+        }
+        // ponderhit, the opponent played the expected move and the clock starts now
+        if (_pondering && !_limits.pondering->load(std::memory_order_relaxed)) {
+            _pondering = false;
+            _timeManager.start(_limits.time, _rootSide);
+        }
+    }
+    return _stopped;
+}
+
+bool ChessSearch::isExcludedRootMove(const BitMove &move) const
+{
+    for (int i = 0; i < _excludedRootCount; i++) {
+        if (_excludedRootMoves[i] == move) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ChessSearch::makeMove(const BitMove &move)
+{
+    if (_useNnue) {
+        _nnue.push(_position, move);
+    }
+    _position.makeMove(move);
+}
+
+void ChessSearch::unmakeMove(const BitMove &move)
+{
+    _position.unmakeMove(move);
+    if (_useNnue) {
+        _nnue.pop();
+    }
+}
+
+void ChessSearch::makeNullMove()
+{
+    if (_useNnue) {
+        _nnue.pushNull();
+    }
+    _position.makeNullMove();
+}
+
+void ChessSearch::unmakeNullMove()
+{
+    _position.unmakeNullMove();
+    if (_useNnue) {
+        _nnue.pop();
+    }
+}
+
+int ChessSearch::staticEvaluation()
+{
+    _evalCounters.evaluations++;
+    int score;
+    if (_evalCache.probe(_position.key(), score)) {
+        _evalCounters.cacheHits++;
+        return score;
+    }
+    score = _useNnue ? _nnue.evaluate(_position) : evaluate(_position, _pawnTable);
+    _evalCache.store(_position.key(), score);
+    return score;
+}
+
+int ChessSearch::lazyEvaluation(int alpha, int beta)
+{
+    // the network is cheap enough to always run in full
+    if (_useNnue) {
+        return staticEvaluation();
+    }
+    _evalCounters.evaluations++;
+    int score;
+    if (_evalCache.probe(_position.key(), score)) {
+        _evalCounters.cacheHits++;
+        return score;
+    }
+    bool lazy;
+    score = evaluate(_position, _pawnTable, alpha, beta, lazy);
+    if (lazy) {
+        _evalCounters.lazyExits++;
+    } else {
+        _evalCache.store(_position.key(), score);
+    }
+    return score;
+}
+
+bool ChessSearch::hasLegalMove() const
+{
+    MoveList moves;
+    generateLegalMoves(_position, moves);
+    return !moves.empty();
+}
+
+EvalCounters ChessSearch::evalCounters() const
+{
+    EvalCounters counters = _evalCounters;
+    counters.pawnProbes = _pawnTable.probes();
+    counters.pawnHits = _pawnTable.hits();
+    return counters;
+}
+
+SearchResult ChessSearch::search(const ChessPosition &root, const SearchLimits &limits)
+{
+    _position = root;
+    _position.makeRoomInHistory(MaxSearchPly);
+    _limits = limits;
+    _limits.maxPly = std::clamp(_limits.maxPly, 1, MaxSearchPly);
+    _limits.depth = std::clamp(_limits.depth, 1, _limits.maxPly);
+    _stopped = false;
+    _rootSide = root.sideToMove();
+    _rootPly = _position.historyPly();
+    // a ponder search has no clock until ponderhit
+    _pondering = _limits.pondering && _limits.pondering->load(std::memory_order_relaxed);
+    _timeManager.start(_pondering ? TimeControl() : _limits.time, _rootSide);
+    _nodes = 0;
+    _pawnTable.resetCounters();
+    _evalCounters = EvalCounters();
+    // cached scores from the other evaluator would mix the two
+    if (evaluatorChanged()) {
+        _evalCache.clear();
+        if (!_sharedStop) {
+            _table.clear();
+        }
+    }
+    _useNnue = _options.nnue && nnueLoaded();
+    if (_useNnue) {
+        _nnue.reset(_position);
+        _nnue.resetCounters();
+    }
+    _publishedNodes.store(0, std::memory_order_relaxed);
+    // a search running alongside others leaves the table generation to its owner
+    if (!_sharedStop) {
+        _table.newSearch();
+    }
+    // killers belong to the old tree, history still ranks moves well
+    for (auto &killer : _history.killers) {
+        killer[0] = BitMove();
+        killer[1] = BitMove();
+    }
+
+    SearchResult result{};
+    MoveList rootMoves;
+    generateLegalMoves(_position, rootMoves);
+    if (rootMoves.empty()) {
+        result.score = _position.inCheck() ? -ScoreMate : 0;
+        return result;
+    }
+    // something legal to play even if the first iteration never finishes
+    result.bestMove = rootMoves[0];
+
+    auto start = std::chrono::steady_clock::now();
+    int lines = std::clamp(_limits.multiPV, 1, rootMoves.size());
+    std::vector<int> lineScores(lines, 0);
+    int stableIterations = 0;
+    for (int depth = 1; depth <= _limits.depth; depth++) {
+        if (_threadIndex > 0) {
+            int skip = (_threadIndex - 1) % kSkipPatterns;
+            if (((depth + kSkipPhase[skip]) / kSkipSize[skip]) % 2) {
+                continue;
+            }
+        }
+
+        // each multipv line searches the root without the best moves of the lines before it
+        _excludedRootCount = 0;
+        for (int line = 0; line < lines; line++) {
+            _selDepth = 0;
+
+            // aspiration window around the previous score, widened on the side that failed
+            int delta = 25;
+            int alpha = -ScoreInfinite;
+            int beta = ScoreInfinite;
+            if (depth >= 5) {
+                alpha = std::max(lineScores[line] - delta, -ScoreInfinite);
+                beta = std::min(lineScores[line] + delta, (int)ScoreInfinite);
+            }
+            int iterationScore;
+            while (true) {
+                iterationScore = searchNode(alpha, beta, depth, 0, true);
+                if (_stopped) {
+                    break;
+                }
+                if (iterationScore <= alpha) {
+                    beta = (alpha + beta) / 2;
+                    alpha = std::max(iterationScore - delta, -ScoreInfinite);
+                } else if (iterationScore >= beta) {
+                    beta = std::min(iterationScore + delta, (int)ScoreInfinite);
+                } else {
+                    break;
+                }
+                delta += delta;
+            }
+            if (_stopped) {
+                break;
+            }
+
+            lineScores[line] = iterationScore;
+            if (line == 0) {
+                stableIterations = (depth > 1 && _pv[0][0] == result.bestMove) ? stableIterations + 1 : 0;
+                result.bestMove = _pv[0][0];
+                result.ponderMove = _pvLength[0] > 1 ? _pv[0][1] : BitMove();
+                result.score = iterationScore;
+                result.depth = depth;
+            }
+
+            if (onIteration) {
+                _publishedNodes.store(_nodes, std::memory_order_relaxed);
+                double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                SearchInfo info;
+                info.depth = depth;
+                info.selDepth = _selDepth;
+                info.score = iterationScore;
+                info.nodes = _nodes;
+                info.nps = (uint64_t)(seconds > 0 ? _nodes / seconds : 0);
+                info.timeMs = (int)(seconds * 1000);
+                info.hashfull = _table.hashfull();
+                info.multiPV = lines > 1 ? line + 1 : 0;
+                info.pv.assign(_pv[0], _pv[0] + _pvLength[0]);
+                onIteration(info);
+            }
+            _excludedRootMoves[_excludedRootCount++] = _pv[0][0];
+        }
+        _excludedRootCount = 0;
+        if (_stopped) {
+            break;
+        }
+
+        // no point looking deeper once a mate well inside the horizon is proven, with the
+        // selective search (and the other threads' table entries) the first mate found is
+        // not always the shortest, so keep going until twice its distance has been searched
+        int score = lineScores[0];
+        if (lines == 1 && std::abs(score) >= ScoreMateInMaxPly && 2 * (ScoreMate - std::abs(score)) <= depth) {
+            break;
+        }
+        if (_timeManager.shouldStopAfterIteration(stableIterations)) {
+            break;
+        }
+    }
+    result.nodes = _nodes;
+    _publishedNodes.store(_nodes, std::memory_order_relaxed);
+    _stopRequested.store(false, std::memory_order_relaxed);
+    return result;
+}
+
+int ChessSearch::searchNode(int alpha, int beta, int depth, int ply, bool pvNode, bool allowNull)
+{
+    bool inCheck = _position.inCheck();
+    // check extension, never leave a forced sequence of checks at the horizon
+    if (inCheck) {
+        depth++;
+    }
+    if (depth <= 0) {
+        return quiescence(alpha, beta, ply);
+    }
+
+    _pvLength[ply] = 0;
+    _nodes++;
+    if (shouldStop()) {
+        return 0;
+    }
+    _selDepth = std::max(_selDepth, ply);
+    if (ply >= _limits.maxPly) {
+        return staticEvaluation();
+    }
+
+    if (ply > 0) {
+        // draws, unless the move that reached the fifty-move limit mated
+        if (_position.isRepetition(_rootPly) || (_position.isFiftyMoveDraw() && (!inCheck || hasLegalMove()))) {
+            return 0;
+        }
+
+        // mate distance pruning, nothing here can beat a mate already found closer to the root
+        alpha = std::max(alpha, -ScoreMate + ply);
+        beta = std::min(beta, ScoreMate - ply - 1);
+        if (alpha >= beta) {
+            return alpha;
+        }
+    }
+
+    uint16_t tableMove = 0;
+    bool tableHit = false;
+    TTData entry;
+    if (_table.probe(_position.key(), entry)) {
+        tableHit = true;
+        tableMove = entry.move;
+        int tableScore = scoreFromTable(entry.score, ply);
+        if (!pvNode && entry.depth >= depth
+            && ((entry.bound == BoundExact)
+                || (entry.bound == BoundLower && tableScore >= beta)
+                || (entry.bound == BoundUpper && tableScore <= alpha))) {
+            return tableScore;
+        }
+    }
+
+    int us = _position.sideToMove();
+    int staticEval = -ScoreInfinite;
+    if (!inCheck) {
+        staticEval = tableHit ? entry.eval : staticEvaluation();
+    }
+
+    if (!pvNode && !inCheck && std::abs(beta) < ScoreMateInMaxPly) {
+        // reverse futility, far enough above beta that no quiet move will bring it back
+        if (_options.reverseFutility && depth <= 6 && staticEval - 80 * depth >= beta) {
+            return staticEval;
+        }
+
+        // razoring, so far below alpha that only a tactic could help, which quiescence will find
+        if (_options.razoring && depth <= 3 && staticEval + 200 + 250 * depth * depth < alpha) {
+            int score = quiescence(alpha - 1, alpha, ply);
+            if (score < alpha) {
+                return score;
+            }
+        }
+
+        // null move, if passing still fails high a real move will too
+        // never twice in a row, and not with only pawns left where zugzwang is common
+        // nor with a piece attacked by a pawn, passing there just loses the piece and the
+        // null search fails low, on the tactical bench positions that cost more nodes than
+        // it saved until this was left out, along with depth 3
+        // the reduction grows with the depth and with how far the eval is above beta
+        uint64_t nonPawnMaterial = _position.occupancy(us) & ~_position.pieces(us, Pawn) & ~_position.pieces(us, King);
+        uint64_t theirPawns = _position.pieces(us ^ 1, Pawn);
+        uint64_t pawnThreats = us == White ? BLACK_PAWN_ATTACKS(theirPawns) : WHITE_PAWN_ATTACKS(theirPawns);
+        if (_options.nullMove && allowNull && depth >= 4 && staticEval >= beta && nonPawnMaterial
+            && !(pawnThreats & nonPawnMaterial)) {
+            int reduction = 3 + depth / 3 + std::min((staticEval - beta) / 200, 3);
+            _currentMove[ply] = BitMove();
+            makeNullMove();
+            int score = -searchNode(-beta, -beta + 1, depth - 1 - reduction, ply + 1, false, false);
+            unmakeNullMove();
+            if (_stopped) {
+                return 0;
+            }
+            if (score >= beta) {
+                // an unproven mate from a null move search is not trusted
+                if (score >= ScoreMateInMaxPly) {
+                    score = beta;
+                }
+                // deep down, check with a real reduced search in case this is a zugzwang
+                if (depth < 10) {
+                    return score;
+                }
+                int verified = searchNode(beta - 1, beta, depth - 1 - reduction, ply, false, false);
+                if (verified >= beta) {
+                    return score;
+                }
+            }
+        }
+    }
+
+    BitMove previous = ply > 0 ? _currentMove[ply - 1] : BitMove();
+    MovePicker picker(_position, tableMove, _history, ply, previous);
+
+    int originalAlpha = alpha;
+    int bestScore = -ScoreInfinite;
+    BitMove bestMove;
+    int moveCount = 0;
+    BitMove quietsTried[64];
+    int quietCount = 0;
+    BitMove move;
+    while (picker.next(move)) {
+        if (ply == 0 && _excludedRootCount && isExcludedRootMove(move)) {
+            continue;
+        }
+        moveCount++;
+        bool quiet = !isTactical(_position, move);
+
+        if (!pvNode && !inCheck && moveCount > 1 && bestScore > -ScoreMateInMaxPly) {
+            // late move pruning, the quiet moves ordered this far back hardly ever matter
+            if (_options.lateMovePruning && depth <= 8 && quietCount >= 3 + depth * depth) {
+                picker.skipQuiets();
+            }
+            // near the leaves skip moves that lose more material than the remaining depth can win back
+            if (depth <= 3 && !seeGreaterEqual(_position, move, -100 * depth)) {
+                continue;
+            }
+        }
+
+        _currentMove[ply] = move;
+        makeMove(move);
+        bool givesCheck = _position.inCheck();
+
+        // futility, a quiet move that does not check cannot lift a hopeless static eval to alpha
+        if (_options.futility && !pvNode && !inCheck && !givesCheck && quiet && moveCount > 1
+            && depth <= 6 && bestScore > -ScoreMateInMaxPly && staticEval + 100 + 100 * depth <= alpha) {
+            unmakeMove(move);
+            if (quietCount < 64) {
+                quietsTried[quietCount++] = move;
+            }
+            continue;
+        }
+        _table.prefetch(_position.key());
+
+        int score;
+        if (moveCount == 1) {
+            score = -searchNode(-beta, -alpha, depth - 1, ply + 1, pvNode);
+        } else {
+            // late move reductions, quiet moves late in the list are searched shallower first
+            int reduction = 0;
+            if (_options.lateMoveReductions && depth >= 3 && moveCount > (pvNode ? 3 : 1) && quiet && !inCheck && !givesCheck) {
+                reduction = lateMoveReduction(depth, moveCount);
+                if (pvNode) {
+                    reduction--;
+                }
+                if (move == _history.killers[ply][0] || move == _history.killers[ply][1]) {
+                    reduction--;
+                }
+                reduction = std::clamp(reduction, 0, depth - 2);
+            }
+
+            // every later move is expected to fail low, prove it with a null window
+            score = -searchNode(-alpha - 1, -alpha, depth - 1 - reduction, ply + 1, false);
+            if (reduction && score > alpha) {
+                score = -searchNode(-alpha - 1, -alpha, depth - 1, ply + 1, false);
+            }
+            if (score > alpha && score < beta) {
+                score = -searchNode(-beta, -alpha, depth - 1, ply + 1, true);
+            }
+        }
+        unmakeMove(move);
+
+        if (_stopped) {
+            return 0;
+        }
+        if (score > bestScore) {
+            bestScore = score;
+            if (score > alpha) {
+                alpha = score;
+                bestMove = move;
+                _pv[ply][0] = move;
+                for (int j = 0; j < _pvLength[ply + 1]; j++) {
+                    _pv[ply][j + 1] = _pv[ply + 1][j];
+                }
+                _pvLength[ply] = _pvLength[ply + 1] + 1;
+                if (alpha >= beta) {
+                    break;
+                }
+            }
+        }
+        if (quiet && quietCount < 64) {
+            quietsTried[quietCount++] = move;
+        }
+    }
+
+    if (!moveCount) {
+        return inCheck ? -ScoreMate + ply : 0;
+    }
+    // every move was pruned, the static eval is the best guess there is
+    if (bestScore == -ScoreInfinite) {
+        bestScore = staticEval;
+    }
+
+    // a quiet cutoff move becomes a killer and countermove, it gains history and
+    // every quiet move tried before it loses the same amount
+    if (bestScore >= beta && bestMove.piece != NoPiece && !isTactical(_position, bestMove)) {
+        int bonus = depth * depth;
+        _history.addKiller(ply, bestMove);
+        _history.setCounterMove(us ^ 1, previous, bestMove);
+        _history.updateHistory(us, bestMove, bonus);
+        for (int i = 0; i < quietCount; i++) {
+            _history.updateHistory(us, quietsTried[i], -bonus);
+        }
+    }
+
+    // a root searched without some of its moves is not a result for the position
+    if (ply == 0 && _excludedRootCount) {
+        return bestScore;
+    }
+    TTBound bound = bestScore >= beta ? BoundLower : bestScore > originalAlpha ? BoundExact : BoundUpper;
+    _table.store(_position.key(), depth, bound, scoreToTable(bestScore, ply), staticEval == -ScoreInfinite ? 0 : staticEval,
+                 bestMove.piece != NoPiece ? encodeMove(bestMove) : 0);
+    return bestScore;
+}
+
+int ChessSearch::quiescence(int alpha, int beta, int ply)
+{
+    _pvLength[ply] = 0;
+    _nodes++;
+    if (shouldStop()) {
+        return 0;
+    }
+    _selDepth = std::max(_selDepth, ply);
+
+    bool inCheck = _position.inCheck();
+    if (ply >= _limits.maxPly) {
+        return inCheck ? 0 : staticEvaluation();
+    }
+
+    // stand pat, the side to move can usually decline every capture
+    int standPat = -ScoreInfinite;
+    int bestScore = -ScoreInfinite;
+    if (!inCheck) {
+        standPat = lazyEvaluation(alpha, beta);
+        if (standPat >= beta) {
+            return standPat;
+        }
+        alpha = std::max(alpha, standPat);
+        bestScore = standPat;
+    }
+
+    // in check every evasion is searched, there is no standing pat
+    MovePicker picker(_position, _history);
+    int moveCount = 0;
+    BitMove move;
+    while (picker.next(move)) {
+        moveCount++;
+        // delta pruning, even winning the piece outright would not reach alpha
+        if (!inCheck && move.kind() != MovePromotion) {
+            int victim = move.kind() == MoveEnPassant ? Pawn : pieceTypeOf(_position.pieceOn(move.to));
+            if (standPat + kPieceValues[victim] + kDeltaMargin <= alpha) {
+                continue;
+            }
+        }
+
+        makeMove(move);
+        int score = -quiescence(-beta, -alpha, ply + 1);
+        unmakeMove(move);
+
+        if (_stopped) {
+            return 0;
+        }
+        if (score > bestScore) {
+            bestScore = score;
+            if (score > alpha) {
+                alpha = score;
+                if (alpha >= beta) {
+                    break;
+                }
+            }
+        }
+    }
+    if (inCheck && !moveCount) {
+        return -ScoreMate + ply;
+    }
+    return bestScore;
+}
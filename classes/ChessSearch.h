@@ -0,0 +1,171 @@
+#pragma once
+
+#include "ChessEval.h"
+#include "ChessMovePicker.h"
+#include "ChessNnue.h"
+#include "ChessTimeManager.h"
+#include "TranspositionTable.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+//
+// iterative deepening principal variation search
+//
+// each iteration searches the whole tree one ply deeper, seeded by the
+// transposition table and the previous best move, so the total cost is barely
+// more than the last iteration alone and there is always a finished move to play
+// from depth 5 on the root window is narrowed around the last score and only
+// widened again when the result falls outside it
+// away from the principal variation the tree is cut down by null move pruning,
+// late move reductions, reverse futility, futility, late move pruning and razoring
+// the horizon is resolved by a quiescence search over captures and promotions
+// that skips anything static exchange evaluation says loses material
+//
+
+constexpr int ScoreInfinite = 32000;
+constexpr int ScoreMate = 31000;
+// any score beyond this is a forced mate
+constexpr int ScoreMateInMaxPly = ScoreMate - MaxSearchPly;
+
+struct SearchLimits
+{
+    // nominal iterative deepening depth
+    int depth = MaxSearchPly - 1;
+    // hard cap on the distance from the root, check extensions included
+    int maxPly = MaxSearchPly;
+    // stop after roughly this many nodes, 0 for no limit
+    uint64_t nodes = 0;
+    // clock limits, the search runs to depth when none are set
+    TimeControl time;
+    // cancellation token owned by the caller, the search stops soon after it turns true
+    const std::atomic<bool> *cancel = nullptr;
+    // while this reads true the search is pondering and the clock is not running,
+    // the time limits start counting once it turns false (uci ponderhit)
+    const std::atomic<bool> *pondering = nullptr;
+    // how many of the best root moves to search fully, each with its own principal variation
+    int multiPV = 1;
+};
+
+// the selective search features, all on by default, each can be switched off for A/B testing
+struct SearchOptions
+{
+    bool nullMove = true;
+    bool lateMoveReductions = true;
+    bool reverseFutility = true;
+    bool futility = true;
+    bool lateMovePruning = true;
+    bool razoring = true;
+    // evaluate with the loaded network instead of the hand written terms, see ChessNnue.h
+    bool nnue = false;
+};
+
+// what each finished iteration reports
+struct SearchInfo
+{
+    int depth;
+    int selDepth;
+    int score;
+    uint64_t nodes;
+    uint64_t nps;
+    int timeMs;
+    int hashfull;
+    // 1 for the best line, 2 for the second best and so on, 0 when only one line is searched
+    int multiPV;
+    std::vector<BitMove> pv;
+};
+
+struct SearchResult
+{
+    BitMove bestMove;
+    // the expected reply, empty if the principal variation stops at the best move
+    BitMove ponderMove;
+    int score;
+    int depth;
+    uint64_t nodes;
+};
+
+class ChessSearch
+{
+public:
+    explicit ChessSearch(TranspositionTable &table);
+
+    SearchResult search(const ChessPosition &root, const SearchLimits &limits);
+
+    // safe to call from another thread, the search returns its last finished iteration
+    void stop() { _stopRequested.store(true, std::memory_order_relaxed); }
+
+    // nodes searched so far, published every 1024 nodes so other threads can read it
+    uint64_t nodes() const { return _publishedNodes.load(std::memory_order_relaxed); }
+    // static evaluation costs of the last search
+    EvalCounters evalCounters() const;
+
+    // helper threads of a parallel search skip some depths so the threads spread over
+    // different iterations instead of all searching the same one, index 0 is the main thread
+    void setThreadIndex(int index) { _threadIndex = index; }
+    // an extra stop flag owned by whoever runs several searches together
+    void setSharedStop(const std::atomic<bool> *stop) { _sharedStop = stop; }
+
+    void setOptions(const SearchOptions &options) { _options = options; }
+    // the options switch between the network and the hand written evaluation, so the static
+    // evals kept in the table come from the other one, whoever owns the table clears it
+    bool evaluatorChanged() const { return _useNnue != (_options.nnue && nnueLoaded()); }
+    const SearchOptions &options() const { return _options; }
+
+    // called after every finished iteration, prints a uci style info line by default
+    std::function<void(const SearchInfo &)> onIteration;
+
+    static void printInfo(const SearchInfo &info);
+
+private:
+    int searchNode(int alpha, int beta, int depth, int ply, bool pvNode, bool allowNull = true);
+    // captures and promotions only, until the position is quiet
+    int quiescence(int alpha, int beta, int ply);
+    bool shouldStop();
+    // board updates that keep the network's accumulators in step when it is in use
+    void makeMove(const BitMove &move);
+    void unmakeMove(const BitMove &move);
+    void makeNullMove();
+    void unmakeNullMove();
+    // exact, through the evaluation cache
+    int staticEvaluation();
+    // for telling a mate on the fiftieth move from a draw
+    bool hasLegalMove() const;
+    // may stop at a cheap estimate when the score is far outside alpha..beta, for stand pat
+    int lazyEvaluation(int alpha, int beta);
+    bool isExcludedRootMove(const BitMove &move) const;
+
+    TranspositionTable &_table;
+    ChessPosition _position;
+    SearchLimits _limits;
+    SearchOptions _options;
+    TimeManager _timeManager;
+    std::atomic<bool> _stopRequested;
+    const std::atomic<bool> *_sharedStop;
+    bool _stopped;
+    bool _pondering;
+    int _rootSide;
+    // history ply of the root, repetitions after it are draws at the second occurrence
+    int _rootPly;
+    uint64_t _nodes;
+    std::atomic<uint64_t> _publishedNodes;
+    int _threadIndex;
+    int _selDepth;
+
+    MoveHistory _history;
+    PawnHashTable _pawnTable;
+    EvalCache _evalCache;
+    EvalCounters _evalCounters;
+    NnueEvaluator _nnue;
+    bool _useNnue;
+    // the move being searched at each ply, for countermoves
+    BitMove _currentMove[MaxSearchPly + 1];
+    // root moves already reported on earlier multipv lines of this iteration
+    BitMove _excludedRootMoves[MaxMoves];
+    int _excludedRootCount;
+
+    // triangular principal variation table
+    BitMove _pv[MaxSearchPly + 1][MaxSearchPly + 1];
+    int _pvLength[MaxSearchPly + 1];
+};
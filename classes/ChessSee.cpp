@@ -0,0 +1,77 @@
+#include "ChessSee.h"
+#include "ChessEval.h"
+#include "ChessMoveGen.h"
+
+bool seeGreaterEqual(const ChessPosition &position, const BitMove &move, int threshold)
+{
+    if (move.kind() == MoveCastle) {
+        return threshold <= 0;
+    }
+
+    int from = move.from;
+    int to = move.to;
+    int captured = move.kind() == MoveEnPassant ? Pawn : pieceTypeOf(position.pieceOn(to));
+    int moving = move.kind() == MovePromotion ? move.promotion() : move.piece;
+
+    // what we win straight away, promotion included
+    int swap = kPieceValues[captured] - threshold;
+    if (move.kind() == MovePromotion) {
+        swap += kPieceValues[moving] - kPieceValues[Pawn];
+    }
+    if (swap < 0) {
+        return false;
+    }
+    // still ahead even if the moving piece is lost for nothing
+    swap = kPieceValues[moving] - swap;
+    if (swap <= 0) {
+        return true;
+    }
+
+    uint64_t occupied = position.occupied() ^ (1ULL << from) ^ (1ULL << to);
+    if (move.kind() == MoveEnPassant) {
+        occupied ^= 1ULL << (to ^ 8);
+    }
+    uint64_t bishopLike = position.pieces(White, Bishop) | position.pieces(Black, Bishop)
+                        | position.pieces(White, Queen) | position.pieces(Black, Queen);
+    uint64_t rookLike = position.pieces(White, Rook) | position.pieces(Black, Rook)
+                      | position.pieces(White, Queen) | position.pieces(Black, Queen);
+    uint64_t attackers = position.attackersTo(to, occupied);
+
+    int side = position.sideToMove();
+    int result = 1;
+    while (true) {
+        side ^= 1;
+        attackers &= occupied;
+        uint64_t ours = attackers & position.occupancy(side);
+        if (!ours) {
+            break;
+        }
+        result ^= 1;
+
+        // recapture with the least valuable attacker and uncover whatever stood behind it
+        int piece = Pawn;
+        uint64_t candidates = 0ULL;
+        for (; piece <= King; piece++) {
+            candidates = ours & position.pieces(side, piece);
+            if (candidates) {
+                break;
+            }
+        }
+        if (piece == King) {
+            // the king may only take last, when nothing can take it back
+            return (attackers & ~position.occupancy(side)) ? result ^ 1 : result;
+        }
+        swap = kPieceValues[piece] - swap;
+        if (swap < result) {
+            break;
+        }
+        occupied ^= candidates & (~candidates + 1);
+        if (piece == Pawn || piece == Bishop || piece == Queen) {
+            attackers |= getBishopAttacks(to, occupied) & bishopLike;
+        }
+        if (piece == Rook || piece == Queen) {
+            attackers |= getRookAttacks(to, occupied) & rookLike;
+        }
+    }
+    return result != 0;
+}
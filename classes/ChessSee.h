@@ -0,0 +1,14 @@
+#pragma once
+
+#include "ChessPosition.h"
+
+//
+// static exchange evaluation
+// plays out every capture on the target square, cheapest attacker first, and
+// lets either side stop when continuing would lose material
+// x-ray attackers behind the pieces that have already captured join in as the
+// occupancy shrinks, pins are ignored
+//
+
+// true if the exchange started by move wins at least threshold centipawns
+bool seeGreaterEqual(const ChessPosition &position, const BitMove &move, int threshold = 0);
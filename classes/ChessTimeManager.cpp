@@ -0,0 +1,61 @@
+#include "ChessTimeManager.h"
+#include <algorithm>
+
+// with no movestogo the game is assumed to last this many more moves
+static constexpr int kDefaultMovesToGo = 30;
+
+TimeManager::TimeManager()
+    : _start(std::chrono::steady_clock::now()), _enabled(false), _fixedMoveTime(false), _softLimit(0), _hardLimit(0)
+{
+}
+
+int64_t TimeManager::elapsed() const
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _start).count();
+}
+
+void TimeManager::start(const TimeControl &control, int sideToMove)
+{
+    _start = std::chrono::steady_clock::now();
+    _enabled = control.isLimited();
+    _fixedMoveTime = control.moveTime > 0;
+    if (!_enabled) {
+        return;
+    }
+
+    if (control.moveTime > 0) {
+        // a fixed time per move is all hard limit, there is nothing to save up for
+        _hardLimit = std::max<int64_t>(1, control.moveTime - control.moveOverhead);
+        _softLimit = _hardLimit;
+        return;
+    }
+
+    int64_t remaining = std::max<int64_t>(1, control.time[sideToMove] - control.moveOverhead);
+    int64_t increment = control.increment[sideToMove];
+    int movesToGo = control.movesToGo > 0 ? std::min(control.movesToGo, 50) : kDefaultMovesToGo;
+
+    // an even share of what is left plus most of the increment, and up to five
+    // times that when the search is unsettled, never more than most of the clock
+    _softLimit = remaining / movesToGo + increment * 3 / 4;
+    _hardLimit = std::min(_softLimit * 5, remaining * 4 / 5);
+    if (movesToGo == 1) {
+        _hardLimit = remaining * 9 / 10;
+    }
+    _softLimit = std::max<int64_t>(1, std::min(_softLimit, _hardLimit));
+    _hardLimit = std::max(_hardLimit, _softLimit);
+}
+
+bool TimeManager::shouldStopAfterIteration(int stableIterations) const
+{
+    // a fixed move time is used in full
+    if (!_enabled || _fixedMoveTime) {
+        return false;
+    }
+    // a best move that keeps changing earns extra time, a settled one gives some back
+    static const int kScalePercent[] = { 150, 120, 100, 90, 80, 70 };
+    int scale = kScalePercent[std::min(stableIterations, 5)];
+    int64_t target = std::min(_softLimit * scale / 100, _hardLimit);
+    // the next iteration takes several times as long as this one, so do not start
+    // one that has little chance of finishing
+    return elapsed() >= target * 6 / 10;
+}
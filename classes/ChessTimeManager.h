@@ -0,0 +1,52 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+//
+// clock handling for the chess search
+//
+// a soft limit is the time we would like to spend, checked between iterations and
+// scaled by how settled the best move is, and a hard limit is the point where the
+// search is cut off mid iteration, the hard limit is checked from the node polling
+// the search already does, so reading the clock costs nothing per node
+//
+
+// uci style time control, all times in milliseconds, 0 means not given
+struct TimeControl
+{
+    int time[2] = { 0, 0 };
+    int increment[2] = { 0, 0 };
+    int movesToGo = 0;
+    int moveTime = 0;
+    // kept back from every move for the gui and the network
+    int moveOverhead = 10;
+
+    bool isLimited() const { return moveTime > 0 || time[0] > 0 || time[1] > 0; }
+};
+
+class TimeManager
+{
+public:
+    TimeManager();
+
+    // start the clock for the side to move, with no limits the manager never stops anything
+    void start(const TimeControl &control, int sideToMove);
+
+    bool enabled() const { return _enabled; }
+    int64_t elapsed() const;
+    int64_t softLimit() const { return _softLimit; }
+    int64_t hardLimit() const { return _hardLimit; }
+
+    bool hardLimitReached() const { return _enabled && elapsed() >= _hardLimit; }
+    // after a finished iteration, stableIterations is how many iterations in a row
+    // have ended with the same best move
+    bool shouldStopAfterIteration(int stableIterations) const;
+
+private:
+    std::chrono::steady_clock::time_point _start;
+    bool _enabled;
+    bool _fixedMoveTime;
+    int64_t _softLimit;
+    int64_t _hardLimit;
+};
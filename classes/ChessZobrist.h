@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+
+//
+// zobrist hashing keys for chess positions
+// a position's key is the xor of one random number per piece on a square, the side
+// to move, the castling rights and the en passant file
+// the numbers come from a fixed seed so keys are the same in every build and process
+//
+struct ZobristKeys
+{
+    uint64_t pieces[2][7][64];
+    uint64_t sideToMove;
+    uint64_t castling[16];
+    uint64_t enPassantFile[8];
+};
+
+// splitmix64, small and good enough for hashing keys
+constexpr uint64_t zobristNext(uint64_t &state)
+{
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+constexpr ZobristKeys makeZobristKeys()
+{
+    ZobristKeys keys{};
+    uint64_t state = 0x2545F4914F6CDD1DULL;
+    for (int color = 0; color < 2; color++) {
+        for (int piece = 0; piece < 7; piece++) {
+            for (int square = 0; square < 64; square++) {
+                keys.pieces[color][piece][square] = piece ? zobristNext(state) : 0ULL;
+            }
+        }
+    }
+    keys.sideToMove = zobristNext(state);
+    // each castling combination is the xor of its single rights so updates can xor old and new
+    uint64_t single[4];
+    for (int i = 0; i < 4; i++) {
+        single[i] = zobristNext(state);
+    }
+    for (int rights = 0; rights < 16; rights++) {
+        keys.castling[rights] = 0ULL;
+        for (int i = 0; i < 4; i++) {
+            if (rights & (1 << i)) {
+                keys.castling[rights] ^= single[i];
+            }
+        }
+    }
+    for (int file = 0; file < 8; file++) {
+        keys.enPassantFile[file] = zobristNext(state);
+    }
+    return keys;
+}
+
+inline constexpr ZobristKeys kZobrist = makeZobristKeys();
@@ -3,6 +3,8 @@
 #include "BitHolder.h"
 #include "Turn.h"
 #include "../Application.h"
+#include <algorithm>
+#include <cstring>
 
 Game::Game()
 {
@@ -15,6 +17,9 @@ Game::Game()
 	_gameOptions.rowY = 0;
 	_gameOptions.score = 0;
 	_gameOptions.AIDepthSearches = 0;
+	_gameOptions.AIMAXDepth = 0;
+	_gameOptions.AIMoveTime = 0;
+	_gameOptions.AIThreads = 1;
 	_gameOptions.AIvsAI = false;
 
 	_table = nullptr;
@@ -28,14 +33,11 @@ Game::Game()
 	_dragStartPos = ImVec2(0, 0);
 	_dragOffset = ImVec2(0, 0);
 	_oldPos = ImVec2(0, 0);
+	_aiCancelled = false;
 }
 
 Game::~Game()
 {
-	for (auto &_turn : _turns)
-	{
-		delete _turn;
-	}
 	_turns.clear();
 	for (auto &_player : _players)
 	{
@@ -66,9 +68,8 @@ void Game::setNumberOfPlayers(unsigned int n)
 	_gameOptions.gameNumber = 0;
 	_gameOptions.numberOfPlayers = n;
 
-	Turn *turn = Turn::initStartOfGame(this);
 	_turns.clear();
-	_turns.push_back(turn);
+	_turns.push_back(Turn::initStartOfGame(_gameOptions.gameNumber));
 }
 
 void Game::setAIPlayer(unsigned int playerNumber)
@@ -80,26 +81,84 @@ void Game::setAIPlayer(unsigned int playerNumber)
 
 void Game::startGame()
 {
-	std::string startState = stateString();
-	Turn *turn = _turns.at(0);
-	turn->_boardState = startState;
-	turn->_gameNumber = _gameOptions.gameNumber;
+	Turn &turn = _turns.at(0);
+	packState(turn._boardState);
+	turn._gameNumber = _gameOptions.gameNumber;
 	_gameOptions.currentTurnNo = 0;
 }
 
 void Game::endTurn()
 {
 	_gameOptions.currentTurnNo++;
-	std::string startState = stateString();
-	Turn *turn = new Turn;
-	turn->_boardState = stateString();
-	turn->_date = (int)_gameOptions.currentTurnNo;
-	turn->_score = _gameOptions.score;
-	turn->_gameNumber = _gameOptions.gameNumber;
-	_turns.push_back(turn);
+	Turn &turn = _turns.emplace_back();
+	packState(turn._boardState);
+	turn._status = kTurnFinished;
+	turn._date = (int)_gameOptions.currentTurnNo;
+	turn._score = _gameOptions.score;
+	turn._gameNumber = _gameOptions.gameNumber;
 	ClassGame::EndOfTurn();
 }
 
+//
+// the default packing stores stateString() two characters to a byte, a digit in each
+// nibble and 15 after the last one, which covers the digit strings of the grid games
+// a state with any other character is kept as plain text instead, marked by 14 in the
+// first nibble, which no digit packs to, and cut to the 31 characters that fit
+// a state longer than 64 characters needs its own packState
+//
+static const uint8_t kPackedTextMarker = 0xfe;
+
+void Game::packState(PackedState &state)
+{
+	std::string board = stateString();
+	state.fill(0xff);
+	bool digits = true;
+	for (char c : board)
+	{
+		if (c < '0' || c > '9')
+		{
+			digits = false;
+			break;
+		}
+	}
+	if (!digits)
+	{
+		state.fill(0);
+		state[0] = kPackedTextMarker;
+		std::memcpy(state.data() + 1, board.data(), std::min(board.length(), state.size() - 1));
+		return;
+	}
+	for (size_t i = 0; i < board.length() && i < state.size() * 2; i++)
+	{
+		uint8_t digit = (uint8_t)(board[i] - '0');
+		uint8_t &byte = state[i >> 1];
+		byte = (i & 1) ? (uint8_t)((byte & 0x0f) | (digit << 4)) : (uint8_t)((byte & 0xf0) | digit);
+	}
+}
+
+void Game::unpackState(const PackedState &state)
+{
+	std::string board;
+	if (state[0] == kPackedTextMarker)
+	{
+		const char *text = (const char *)state.data() + 1;
+		board.assign(text, strnlen(text, state.size() - 1));
+		setStateString(board);
+		return;
+	}
+	board.reserve(state.size() * 2);
+	for (size_t i = 0; i < state.size() * 2; i++)
+	{
+		uint8_t digit = (state[i >> 1] >> ((i & 1) * 4)) & 15;
+		if (digit == 15)
+		{
+			break;
+		}
+		board += (char)('0' + digit);
+	}
+	setStateString(board);
+}
+
 //
 // scan for mouse is temporarily in the actual game class
 // this will be moved to a higher up class when the squares have a heirarchy
@@ -244,6 +303,38 @@ bool Game::gameHasAI()
 
 void Game::updateAI()
 {
+	if (!_aiResult.valid())
+	{
+		_aiCancelled = false;
+		_aiResult = std::async(std::launch::async, [this]() {
+			return searchAIMove(_aiCancelled);
+		});
+		return;
+	}
+	if (_aiResult.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+	{
+		return;
+	}
+	std::function<void()> playMove = _aiResult.get();
+	if (playMove)
+	{
+		playMove();
+	}
+}
+
+std::function<void()> Game::searchAIMove(const std::atomic<bool> &cancelled)
+{
+	return nullptr;
+}
+
+void Game::cancelAI()
+{
+	if (_aiResult.valid())
+	{
+		_aiCancelled = true;
+		_aiResult.wait();
+		_aiResult = std::future<std::function<void()>>();
+	}
 }
 
 void Game::mouseDown(ImVec2 &location, Entity *entity)
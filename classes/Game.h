@@ -11,6 +11,7 @@
 #include <atomic>
 #include <chrono>
 #include <ctime>
+#include <functional>
 #include <future>
 
 #ifdef _MSC_VER
@@ -41,6 +42,10 @@ struct GameOptions
 	int score;
 	int AIDepthSearches;
 	int AIMAXDepth;
+	// milliseconds the AI may think per move, 0 searches to AIDepthSearches however long it takes
+	int AIMoveTime;
+	// search threads the AI may use, one by default so a game does not take over the machine
+	int AIThreads;
 	bool AIvsAI;
 };
 
@@ -94,17 +99,32 @@ public:
 
 	virtual void stopGame() = 0;
 	virtual bool gameHasAI();
+	// called every frame while the AI is to move, it never blocks: the first call starts
+	// searchAIMove on a worker thread, later calls poll it and play the move once it is ready
 	virtual void updateAI();
+	// runs on the worker thread, so it may read the game state but must not change it
+	// returns the action that plays the chosen move, which updateAI runs on the main thread
+	// a long search should give up soon after cancelled becomes true
+	virtual std::function<void()> searchAIMove(const std::atomic<bool> &cancelled);
+	// stop a running AI search and wait for the worker, its move is thrown away
+	// games with an AI call this from stopGame and their destructor
+	void cancelAI();
+	bool isAIThinking() const { return _aiResult.valid(); }
 	virtual void pieceTaken(Bit *bit){};
 
 	virtual std::string initialStateString() = 0;
 	virtual std::string stateString() = 0;
 	virtual void setStateString(const std::string &s) = 0;
+	// the board in 32 bytes for the turn history, and back
+	virtual void packState(PackedState &state);
+	virtual void unpackState(const PackedState &state);
 
 	void setNumberOfPlayers(unsigned int playerCount);
 	void setAIPlayer(unsigned int playerNumber);
 	virtual int getAIDepathSearches() { return _gameOptions.AIDepthSearches; };
 	virtual int getAIMAXDepth() { return _gameOptions.AIMAXDepth; };
+	virtual int getAIMoveTime() { return _gameOptions.AIMoveTime; };
+	virtual int getAIThreads() { return _gameOptions.AIThreads; };
 
 	// mouse functions
 	void scanForMouse();
@@ -131,7 +151,7 @@ public:
 	Player *_winner;
 
 	std::vector<Player *> _players;
-	std::vector<Turn *> _turns;
+	std::vector<Turn> _turns;
 
 	std::string _lastMove;
 
@@ -151,4 +171,8 @@ protected:
 	BitHolder *_dropTarget;
 	BitHolder *_oldHolder;
 	bool _dragMoved;
+
+	// background AI search
+	std::future<std::function<void()>> _aiResult;
+	std::atomic<bool> _aiCancelled;
 };
@@ -2,6 +2,8 @@
 #define MAGIC_BITBOARDS_H
 
 #include <stdint.h>
+#include <array>
+#include <mutex>
 
 // Generate rook attacks for a given square and blocking pieces
 static inline uint64_t ratt(int sq, uint64_t block) {
@@ -123,12 +125,12 @@ static inline uint64_t indexToUint64(int index, int bits, uint64_t m) {
 #define SOUTH_EAST(bb) (((bb) & ~0x8080808080808080ULL) >> 7)
 #define SOUTH_WEST(bb) (((bb) & ~0x0101010101010101ULL) >> 9)
 
-// Pawn attack macros
+// Pawn attacks of a whole set of pawns, single squares use the PawnAttacks table
 #define WHITE_PAWN_ATTACKS(pawns) (NORTH_EAST(pawns) | NORTH_WEST(pawns))
 #define BLACK_PAWN_ATTACKS(pawns) (SOUTH_EAST(pawns) | SOUTH_WEST(pawns))
 
 // Size of attack tables for each square
-const int RAttackSize[64] = {
+constexpr int RAttackSize[64] = {
   4096,
   2048,
   2048,
@@ -195,7 +197,7 @@ const int RAttackSize[64] = {
   4096,
 };
 
-const int BAttackSize[64] = {
+constexpr int BAttackSize[64] = {
   64,
   32,
   32,
@@ -262,9 +264,78 @@ const int BAttackSize[64] = {
   64,
 };
 
-// Attack lookup tables
-static uint64_t* RAttacks[64];
-static uint64_t* BAttacks[64];
+// Start of each square's attacks in MagicAttackTable, every square gets exactly the
+// entries its magic can index ("fancy" magics), the bishop tables follow the rook tables
+constexpr int magicTableSize(const int (&sizes)[64]) {
+    int total = 0;
+    for (int square = 0; square < 64; square++) {
+        total += sizes[square];
+    }
+    return total;
+}
+
+constexpr std::array<uint32_t, 64> magicOffsets(const int (&sizes)[64], uint32_t base) {
+    std::array<uint32_t, 64> offsets{};
+    for (int square = 0; square < 64; square++) {
+        offsets[square] = base;
+        base += sizes[square];
+    }
+    return offsets;
+}
+
+constexpr int MagicTableSize = magicTableSize(RAttackSize) + magicTableSize(BAttackSize);
+inline constexpr std::array<uint32_t, 64> ROffsets = magicOffsets(RAttackSize, 0);
+inline constexpr std::array<uint32_t, 64> BOffsets = magicOffsets(BAttackSize, magicTableSize(RAttackSize));
+
+// Slider attack indexing backends, magic multiply-shift works everywhere, PEXT (BMI2)
+// gathers the masked occupancy bits into the index with one instruction
+// both index the same tables: a square's PEXT index never exceeds its magic table size
+// building with -mbmi2 (CMake option CHESS_BMI2) uses PEXT without any runtime check,
+// otherwise initMagicBitboards picks PEXT when the CPU has it (note that AMD before
+// Zen 3 implements it in slow microcode, pass SliderMagic there)
+enum SliderBackend {
+    SliderAuto,
+    SliderMagic,
+    SliderPext
+};
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#define SLIDER_PEXT_ALWAYS 1
+static inline uint64_t pext64(uint64_t source, uint64_t mask) {
+    return _pext_u64(source, mask);
+}
+#elif defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+// inline assembly so the instruction can be used without compiling everything for BMI2
+#define SLIDER_PEXT_AVAILABLE 1
+static inline uint64_t pext64(uint64_t source, uint64_t mask) {
+    uint64_t result;
+    __asm__("pextq %2, %1, %0" : "=r"(result) : "r"(source), "rm"(mask));
+    return result;
+}
+static inline bool cpuHasPext(void) {
+    return __builtin_cpu_supports("bmi2");
+}
+#elif defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#define SLIDER_PEXT_AVAILABLE 1
+static inline uint64_t pext64(uint64_t source, uint64_t mask) {
+    return _pext_u64(source, mask);
+}
+static inline bool cpuHasPext(void) {
+    int info[4];
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 8)) != 0;
+}
+#endif
+
+// set once by initMagicBitboards, before any lookup
+inline bool SliderUsesPext = false;
+
+// Every rook and bishop attack set in one cache-aligned block, shared by every translation
+// unit that includes this header and filled once per process by initMagicBitboards
+alignas(64) inline uint64_t MagicAttackTable[MagicTableSize];
+inline std::once_flag MagicTableInitFlag;
 
 // Magic bitboard shift amounts
 const int RShifts[64] = {
@@ -672,202 +743,118 @@ const uint64_t BMasks[64] = {
   0x40201008040200ULL,
 };
 
-// Pre-calculated knight attack bitboards
-const uint64_t KnightAttacks[64] = {
-  0x20400ULL,
-  0x50800ULL,
-  0xa1100ULL,
-  0x142200ULL,
-  0x284400ULL,
-  0x508800ULL,
-  0xa01000ULL,
-  0x402000ULL,
-  0x2040004ULL,
-  0x5080008ULL,
-  0xa110011ULL,
-  0x14220022ULL,
-  0x28440044ULL,
-  0x50880088ULL,
-  0xa0100010ULL,
-  0x40200020ULL,
-  0x204000402ULL,
-  0x508000805ULL,
-  0xa1100110aULL,
-  0x1422002214ULL,
-  0x2844004428ULL,
-  0x5088008850ULL,
-  0xa0100010a0ULL,
-  0x4020002040ULL,
-  0x20400040200ULL,
-  0x50800080500ULL,
-  0xa1100110a00ULL,
-  0x142200221400ULL,
-  0x284400442800ULL,
-  0x508800885000ULL,
-  0xa0100010a000ULL,
-  0x402000204000ULL,
-  0x2040004020000ULL,
-  0x5080008050000ULL,
-  0xa1100110a0000ULL,
-  0x14220022140000ULL,
-  0x28440044280000ULL,
-  0x50880088500000ULL,
-  0xa0100010a00000ULL,
-  0x40200020400000ULL,
-  0x204000402000000ULL,
-  0x508000805000000ULL,
-  0xa1100110a000000ULL,
-  0x1422002214000000ULL,
-  0x2844004428000000ULL,
-  0x5088008850000000ULL,
-  0xa0100010a0000000ULL,
-  0x4020002040000000ULL,
-  0x400040200000000ULL,
-  0x800080500000000ULL,
-  0x1100110a00000000ULL,
-  0x2200221400000000ULL,
-  0x4400442800000000ULL,
-  0x8800885000000000ULL,
-  0x100010a000000000ULL,
-  0x2000204000000000ULL,
-  0x4020000000000ULL,
-  0x8050000000000ULL,
-  0x110a0000000000ULL,
-  0x22140000000000ULL,
-  0x44280000000000ULL,
-  0x88500000000000ULL,
-  0x10a00000000000ULL,
-  0x20400000000000ULL,
-};
+// Knight, king and pawn attack bitboards, generated at compile time so every
+// Chess instance shares one read-only copy and construction does no work
+template <int Count>
+constexpr uint64_t leaperAttacks(int square, const int (&steps)[Count][2]) {
+    uint64_t attacks = 0;
+    int file = square % 8;
+    int rank = square / 8;
+    for (int i = 0; i < Count; i++) {
+        int f = file + steps[i][0];
+        int r = rank + steps[i][1];
+        if (f >= 0 && f < 8 && r >= 0 && r < 8) {
+            attacks |= 1ULL << SQUARE(r, f);
+        }
+    }
+    return attacks;
+}
+
+constexpr int KnightSteps[8][2] = { {1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2} };
+constexpr int KingSteps[8][2] = { {1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1} };
+// pawn captures, indexed by color, white (0) captures toward rank 8
+constexpr int PawnSteps[2][2][2] = { { {-1, 1}, {1, 1} }, { {-1, -1}, {1, -1} } };
+
+template <int Count>
+constexpr std::array<uint64_t, 64> makeLeaperTable(const int (&steps)[Count][2]) {
+    std::array<uint64_t, 64> table{};
+    for (int square = 0; square < 64; square++) {
+        table[square] = leaperAttacks(square, steps);
+    }
+    return table;
+}
 
-// Pre-calculated king attack bitboards
-const uint64_t KingAttacks[64] = {
-  0x302ULL,
-  0x705ULL,
-  0xe0aULL,
-  0x1c14ULL,
-  0x3828ULL,
-  0x7050ULL,
-  0xe0a0ULL,
-  0xc040ULL,
-  0x30203ULL,
-  0x70507ULL,
-  0xe0a0eULL,
-  0x1c141cULL,
-  0x382838ULL,
-  0x705070ULL,
-  0xe0a0e0ULL,
-  0xc040c0ULL,
-  0x3020300ULL,
-  0x7050700ULL,
-  0xe0a0e00ULL,
-  0x1c141c00ULL,
-  0x38283800ULL,
-  0x70507000ULL,
-  0xe0a0e000ULL,
-  0xc040c000ULL,
-  0x302030000ULL,
-  0x705070000ULL,
-  0xe0a0e0000ULL,
-  0x1c141c0000ULL,
-  0x3828380000ULL,
-  0x7050700000ULL,
-  0xe0a0e00000ULL,
-  0xc040c00000ULL,
-  0x30203000000ULL,
-  0x70507000000ULL,
-  0xe0a0e000000ULL,
-  0x1c141c000000ULL,
-  0x382838000000ULL,
-  0x705070000000ULL,
-  0xe0a0e0000000ULL,
-  0xc040c0000000ULL,
-  0x3020300000000ULL,
-  0x7050700000000ULL,
-  0xe0a0e00000000ULL,
-  0x1c141c00000000ULL,
-  0x38283800000000ULL,
-  0x70507000000000ULL,
-  0xe0a0e000000000ULL,
-  0xc040c000000000ULL,
-  0x302030000000000ULL,
-  0x705070000000000ULL,
-  0xe0a0e0000000000ULL,
-  0x1c141c0000000000ULL,
-  0x3828380000000000ULL,
-  0x7050700000000000ULL,
-  0xe0a0e00000000000ULL,
-  0xc040c00000000000ULL,
-  0x203000000000000ULL,
-  0x507000000000000ULL,
-  0xa0e000000000000ULL,
-  0x141c000000000000ULL,
-  0x2838000000000000ULL,
-  0x5070000000000000ULL,
-  0xa0e0000000000000ULL,
-  0x40c0000000000000ULL,
+inline constexpr std::array<uint64_t, 64> KnightAttacks = makeLeaperTable(KnightSteps);
+inline constexpr std::array<uint64_t, 64> KingAttacks = makeLeaperTable(KingSteps);
+// squares a pawn of each color on a square attacks, [color][square]
+inline constexpr std::array<std::array<uint64_t, 64>, 2> PawnAttacks = {
+    makeLeaperTable(PawnSteps[0]),
+    makeLeaperTable(PawnSteps[1]),
 };
 
 // Helper functions for move generation
 static inline uint64_t getRookAttacks(int square, uint64_t occupied) {
+#if defined(SLIDER_PEXT_ALWAYS)
+    return MagicAttackTable[ROffsets[square] + pext64(occupied, RMasks[square])];
+#else
+#if defined(SLIDER_PEXT_AVAILABLE)
+    if (SliderUsesPext) {
+        return MagicAttackTable[ROffsets[square] + pext64(occupied, RMasks[square])];
+    }
+#endif
     occupied &= RMasks[square];
     occupied *= RMagic[square];
     occupied >>= RShifts[square];
-    return RAttacks[square][occupied];
+    return MagicAttackTable[ROffsets[square] + occupied];
+#endif
 }
 
 static inline uint64_t getBishopAttacks(int square, uint64_t occupied) {
+#if defined(SLIDER_PEXT_ALWAYS)
+    return MagicAttackTable[BOffsets[square] + pext64(occupied, BMasks[square])];
+#else
+#if defined(SLIDER_PEXT_AVAILABLE)
+    if (SliderUsesPext) {
+        return MagicAttackTable[BOffsets[square] + pext64(occupied, BMasks[square])];
+    }
+#endif
     occupied &= BMasks[square];
     occupied *= BMagic[square];
     occupied >>= BShifts[square];
-    return BAttacks[square][occupied];
+    return MagicAttackTable[BOffsets[square] + occupied];
+#endif
 }
 
 static inline uint64_t getQueenAttacks(int square, uint64_t occupied) {
     return getRookAttacks(square, occupied) | getBishopAttacks(square, occupied);
 }
 
-// Initialize magic bitboards
-void initMagicBitboards(void) {
-    int square, i;
-    uint64_t subset, index;
-
-    // Initialize rook attack tables
-    for (square = 0; square < 64; square++) {
-        RAttacks[square] = new uint64_t[RAttackSize[square]];
-        uint64_t mask = RMasks[square];
-        int bits = countOnes(mask);
-        int n = 1 << bits;
-
-        for (i = 0; i < n; i++) {
-            subset = indexToUint64(i, bits, mask);
-            index = (subset * RMagic[square]) >> RShifts[square];
-            RAttacks[square][index] = ratt(square, subset);
-        }
-    }
-
-    // Initialize bishop attack tables
-    for (square = 0; square < 64; square++) {
-        BAttacks[square] = new uint64_t[BAttackSize[square]];
-        uint64_t mask = BMasks[square];
-        int bits = countOnes(mask);
-        int n = 1 << bits;
-
-        for (i = 0; i < n; i++) {
-            subset = indexToUint64(i, bits, mask);
-            index = (subset * BMagic[square]) >> BShifts[square];
-            BAttacks[square][index] = batt(square, subset);
+// Initialize magic bitboards, safe to call from any number of threads and instances,
+// only the first call does any work and picks the backend, later requests are ignored
+// the tables are too big to build at compile time, filling them takes some tens of milliseconds
+inline void initMagicBitboards(SliderBackend backend = SliderAuto) {
+    std::call_once(MagicTableInitFlag, [backend] {
+#if defined(SLIDER_PEXT_ALWAYS)
+        (void)backend;
+        SliderUsesPext = true;
+#elif defined(SLIDER_PEXT_AVAILABLE)
+        SliderUsesPext = backend != SliderMagic && cpuHasPext();
+#else
+        (void)backend;
+#endif
+        for (int square = 0; square < 64; square++) {
+            uint64_t mask = RMasks[square];
+            int bits = countOnes(mask);
+            for (int i = 0; i < (1 << bits); i++) {
+                // PEXT of the i-th subset of the mask is i itself
+                uint64_t subset = indexToUint64(i, bits, mask);
+                uint64_t index = SliderUsesPext ? i : (subset * RMagic[square]) >> RShifts[square];
+                MagicAttackTable[ROffsets[square] + index] = ratt(square, subset);
+            }
+
+            mask = BMasks[square];
+            bits = countOnes(mask);
+            for (int i = 0; i < (1 << bits); i++) {
+                uint64_t subset = indexToUint64(i, bits, mask);
+                uint64_t index = SliderUsesPext ? i : (subset * BMagic[square]) >> BShifts[square];
+                MagicAttackTable[BOffsets[square] + index] = batt(square, subset);
+            }
         }
-    }
+    });
 }
 
-// Cleanup magic bitboard tables
-void cleanupMagicBitboards(void) {
-    int square;
-    for (square = 0; square < 64; square++) {
-        delete[] RAttacks[square];
-        delete[] BAttacks[square];
-    }
+inline const char *sliderBackendName(void) {
+    return SliderUsesPext ? "pext" : "magic";
 }
 
 #endif // MAGIC_BITBOARDS_H
@@ -14,6 +14,7 @@ Othello::Othello() : Game() {
 }
 
 Othello::~Othello() {
+    cancelAI();
     delete _grid;
 }
 
@@ -243,6 +244,7 @@ void Othello::countPieces(int &blackCount, int &whiteCount) const {
 }
 
 void Othello::stopGame() {
+    cancelAI();
     _grid->forEachSquare([](ChessSquare* square, int x, int y) {
         square->destroyBit();
     });
@@ -295,22 +297,25 @@ void Othello::setStateString(const std::string &s) {
     });
 }
 
-void Othello::updateAI() {
-    if (!gameHasAI()) return;
-
+// runs on the AI worker thread, the flips are only counted here, never played
+std::function<void()> Othello::searchAIMove(const std::atomic<bool> &cancelled) {
     Player* aiPlayer = getCurrentPlayer();
     std::vector<std::pair<int, int>> validMoves = getValidMoves(aiPlayer);
 
     if (validMoves.empty()) {
-        _consecutivePasses++;
-        endTurn();
-        return;
+        return [this]() {
+            _consecutivePasses++;
+            endTurn();
+        };
     }
 
     // Find move that flips the most pieces
     int bestX = -1, bestY = -1, maxFlips = 0;
 
     for (const auto& move : validMoves) {
+        if (cancelled) {
+            return nullptr;
+        }
         int x = move.first, y = move.second, totalFlips = 0;
         for (int i = 0; i < 8; i++) {
             totalFlips += checkDirection(x, y, DIRECTIONS[i][0], DIRECTIONS[i][1], aiPlayer);
@@ -322,9 +327,12 @@ void Othello::updateAI() {
         }
     }
 
-    if (bestX >= 0 && bestY >= 0) {
-        actionForEmptyHolder(*_grid->getSquare(bestX, bestY));
+    if (bestX < 0 || bestY < 0) {
+        return nullptr;
     }
+    return [this, bestX, bestY]() {
+        actionForEmptyHolder(*_grid->getSquare(bestX, bestY));
+    };
 }
 
 void Othello::getBoardPosition(BitHolder& holder, int &x, int &y) const {
@@ -24,7 +24,7 @@ public:
     void        stopGame() override;
 
     // AI methods
-    void        updateAI() override;
+    std::function<void()> searchAIMove(const std::atomic<bool> &cancelled) override;
     bool        gameHasAI() override { return true; } // Set to true when AI is implemented
     Grid* getGrid() override { return _grid; }
 
@@ -0,0 +1,107 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(int threadCount)
+    : _pending(0), _nextQueue(0), _stopping(false)
+{
+    if (threadCount < 1) {
+        threadCount = 1;
+    }
+    for (int i = 0; i < threadCount; i++) {
+        _queues.push_back(std::make_unique<WorkQueue>());
+    }
+    for (int i = 0; i < threadCount; i++) {
+        _workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _workAvailable.notify_all();
+    for (auto &worker : _workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(Task task)
+{
+    int index = (int)(_nextQueue.fetch_add(1, std::memory_order_relaxed) % _queues.size());
+    _pending.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(_queues[index]->mutex);
+        _queues[index]->tasks.push_back(std::move(task));
+    }
+    {
+        // taking the lock orders the push against a worker deciding to sleep
+        std::lock_guard<std::mutex> lock(_mutex);
+    }
+    _workAvailable.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _allDone.wait(lock, [this] { return _pending.load() == 0; });
+}
+
+bool ThreadPool::popLocal(int index, Task &task)
+{
+    WorkQueue &queue = *_queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+        return false;
+    }
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::steal(int thief, Task &task)
+{
+    int count = (int)_queues.size();
+    for (int i = 1; i < count; i++) {
+        WorkQueue &queue = *_queues[(thief + i) % count];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(int index)
+{
+    for (;;) {
+        Task task;
+        if (popLocal(index, task) || steal(index, task)) {
+            task();
+            if (_pending.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _allDone.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (_stopping) {
+            return;
+        }
+        // recheck under the lock, submit always takes it after queueing
+        bool haveWork = false;
+        for (auto &queue : _queues) {
+            std::lock_guard<std::mutex> queueLock(queue->mutex);
+            if (!queue->tasks.empty()) {
+                haveWork = true;
+                break;
+            }
+        }
+        if (!haveWork) {
+            _workAvailable.wait(lock);
+        }
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//
+// fixed size thread pool with one task queue per worker
+// a worker runs its own queue from the back and steals from the front of the
+// other queues when it runs dry, so uneven tasks (perft subtrees, search splits)
+// still keep every core busy
+//
+class ThreadPool
+{
+public:
+    using Task = std::function<void()>;
+
+    explicit ThreadPool(int threadCount);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    int threadCount() const { return (int)_workers.size(); }
+
+    // queue a task, tasks are spread round robin over the worker queues
+    void submit(Task task);
+    // block until every submitted task has finished
+    void wait();
+
+private:
+    struct WorkQueue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void workerLoop(int index);
+    bool popLocal(int index, Task &task);
+    bool steal(int thief, Task &task);
+
+    std::vector<std::thread> _workers;
+    std::vector<std::unique_ptr<WorkQueue>> _queues;
+
+    std::mutex _mutex;
+    std::condition_variable _workAvailable;
+    std::condition_variable _allDone;
+    std::atomic<int> _pending;
+    std::atomic<unsigned int> _nextQueue;
+    bool _stopping;
+};
@@ -8,6 +8,7 @@ TicTacToe::TicTacToe()
 
 TicTacToe::~TicTacToe()
 {
+    cancelAI();
     delete _grid;
 }
 
@@ -73,6 +74,7 @@ bool TicTacToe::canBitMoveFromTo(Bit &bit, BitHolder &src, BitHolder &dst)
 //
 void TicTacToe::stopGame()
 {
+    cancelAI();
     _grid->forEachSquare([](ChessSquare* square, int x, int y) {
         square->destroyBit();
     });
@@ -159,9 +161,9 @@ void TicTacToe::setStateString(const std::string &s)
 
 
 //
-// this is the function that will be called by the AI
+// this is the function that will be called by the AI, on a worker thread
 //
-void TicTacToe::updateAI() 
+std::function<void()> TicTacToe::searchAIMove(const std::atomic<bool> &cancelled)
 {
     int bestVal = -1000;
     BitHolder* bestMove = nullptr;
@@ -171,7 +173,7 @@ void TicTacToe::updateAI()
     _grid->forEachSquare([&](ChessSquare* square, int x, int y) {
         int index = y * 3 + x;
         // Check if cell is empty
-        if (state[index] == '0') {
+        if (state[index] == '0' && !cancelled) {
             // Make the move
             state[index] = '2';
             int moveVal = -negamax(state, 0, HUMAN_PLAYER);
@@ -186,11 +188,13 @@ void TicTacToe::updateAI()
     });
 
 
-    // Make the best move
-    if(bestMove) {
-        if (actionForEmptyHolder(*bestMove)) {
-        }
+    // Make the best move, back on the main thread
+    if (!bestMove || cancelled) {
+        return nullptr;
     }
+    return [this, bestMove]() {
+        actionForEmptyHolder(*bestMove);
+    };
 }
 
 bool isAIBoardFull(const std::string& state) {
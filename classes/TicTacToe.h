@@ -27,7 +27,7 @@ public:
     bool        canBitMoveFromTo(Bit &bit, BitHolder &src, BitHolder &dst) override;
     void        stopGame() override;
 
-	void        updateAI() override;
+    std::function<void()> searchAIMove(const std::atomic<bool> &cancelled) override;
     bool        gameHasAI() override { return true; }
     Grid* getGrid() override { return _grid; }
 private:
@@ -0,0 +1,169 @@
+#include "TranspositionTable.h"
+#include <cstdlib>
+#include <new>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+#if defined(_MSC_VER)
+#include <malloc.h>
+#endif
+
+static constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+
+//
+// big tables are aligned to 2MB so the kernel can back them with huge pages,
+// which cuts the TLB misses a random access table like this one causes
+//
+static void *allocateTable(size_t bytes)
+{
+#if defined(_MSC_VER)
+    return _aligned_malloc(bytes, 64);
+#else
+    size_t alignment = bytes >= kHugePageSize ? kHugePageSize : 64;
+    size_t rounded = (bytes + alignment - 1) / alignment * alignment;
+    void *memory = std::aligned_alloc(alignment, rounded);
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (memory && alignment == kHugePageSize) {
+        madvise(memory, rounded, MADV_HUGEPAGE);
+    }
+#endif
+    return memory;
+#endif
+}
+
+static void freeTable(void *memory)
+{
+#if defined(_MSC_VER)
+    _aligned_free(memory);
+#else
+    std::free(memory);
+#endif
+}
+
+TranspositionTable::TranspositionTable()
+    : _buckets(nullptr), _bucketCount(0), _mask(0), _generation(0)
+{
+    resize(16);
+}
+
+TranspositionTable::~TranspositionTable()
+{
+    freeTable(_buckets);
+}
+
+void TranspositionTable::resize(size_t megabytes)
+{
+    size_t bytes = (megabytes ? megabytes : 1) * 1024 * 1024;
+    size_t count = 1;
+    while (count * 2 * sizeof(Bucket) <= bytes) {
+        count *= 2;
+    }
+
+    freeTable(_buckets);
+    _buckets = static_cast<Bucket *>(allocateTable(count * sizeof(Bucket)));
+    if (!_buckets) {
+        throw std::bad_alloc();
+    }
+    for (size_t i = 0; i < count; i++) {
+        new (&_buckets[i]) Bucket();
+    }
+    _bucketCount = count;
+    _mask = count - 1;
+    clear();
+}
+
+void TranspositionTable::clear()
+{
+    for (size_t i = 0; i < _bucketCount; i++) {
+        for (Entry &entry : _buckets[i].entries) {
+            entry.check.store(0, std::memory_order_relaxed);
+            entry.data.store(0, std::memory_order_relaxed);
+        }
+    }
+    _generation = 0;
+}
+
+uint64_t TranspositionTable::pack(uint16_t move, int score, int eval, int depth, int bound, int generation)
+{
+    return (uint64_t)move
+         | ((uint64_t)(uint16_t)(int16_t)score << 16)
+         | ((uint64_t)(uint16_t)(int16_t)eval << 32)
+         | ((uint64_t)(uint8_t)(int8_t)depth << 48)
+         | ((uint64_t)(bound & 3) << 56)
+         | ((uint64_t)(generation & kGenerationMask) << 58);
+}
+
+void TranspositionTable::unpack(uint64_t data, TTData &out)
+{
+    out.move = (uint16_t)data;
+    out.score = (int16_t)(data >> 16);
+    out.eval = (int16_t)(data >> 32);
+    out.depth = (int8_t)(data >> 48);
+    out.bound = (uint8_t)((data >> 56) & 3);
+}
+
+bool TranspositionTable::probe(uint64_t key, TTData &data) const
+{
+    const Bucket &bucket = _buckets[key & _mask];
+    for (const Entry &entry : bucket.entries) {
+        uint64_t packed = entry.data.load(std::memory_order_relaxed);
+        uint64_t check = entry.check.load(std::memory_order_relaxed);
+        if (packed && (check ^ packed) == key) {
+            unpack(packed, data);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TranspositionTable::store(uint64_t key, int depth, TTBound bound, int score, int eval, uint16_t move)
+{
+    Bucket &bucket = _buckets[key & _mask];
+    Entry *replace = nullptr;
+    int worstValue = 0;
+
+    for (Entry &entry : bucket.entries) {
+        uint64_t packed = entry.data.load(std::memory_order_relaxed);
+        uint64_t check = entry.check.load(std::memory_order_relaxed);
+
+        if (packed && (check ^ packed) == key) {
+            // same position, keep a deeper result from this search unless the new one is exact
+            if (bound != BoundExact && generationOf(packed) == _generation && depth < depthOf(packed) - 2) {
+                return;
+            }
+            if (!move) {
+                move = (uint16_t)packed;
+            }
+            replace = &entry;
+            break;
+        }
+
+        // otherwise evict the shallowest entry, entries from old searches count as shallower
+        int age = (_generation - generationOf(packed)) & kGenerationMask;
+        int value = packed ? depthOf(packed) - 8 * age : -1000;
+        if (!replace || value < worstValue) {
+            replace = &entry;
+            worstValue = value;
+        }
+    }
+
+    uint64_t packed = pack(move, score, eval, depth, bound, _generation);
+    replace->data.store(packed, std::memory_order_relaxed);
+    replace->check.store(key ^ packed, std::memory_order_relaxed);
+}
+
+int TranspositionTable::hashfull() const
+{
+    int used = 0;
+    size_t buckets = _bucketCount < 250 ? _bucketCount : 250;
+    for (size_t i = 0; i < buckets; i++) {
+        for (const Entry &entry : _buckets[i].entries) {
+            uint64_t packed = entry.data.load(std::memory_order_relaxed);
+            if (packed && generationOf(packed) == _generation) {
+                used++;
+            }
+        }
+    }
+    return buckets ? (int)(used * 1000 / (buckets * kBucketSize)) : 0;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "Bitboard.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+//
+// shared transposition table for the chess search
+//
+// the table is an array of 64 byte buckets so a probe touches a single cache line
+// each bucket holds four 16 byte entries, and each entry is two 64 bit words:
+// the packed data and the key xor'd with that data
+// readers and writers never lock, a torn entry from two threads racing on the same
+// slot fails the xor check and reads as a miss, so any number of search threads can
+// share one table
+//
+
+enum TTBound
+{
+    BoundNone = 0,
+    BoundUpper = 1,
+    BoundLower = 2,
+    BoundExact = BoundUpper | BoundLower
+};
+
+// what a probe returns
+struct TTData
+{
+    uint16_t move;
+    int16_t score;
+    int16_t eval;
+    int8_t depth;
+    uint8_t bound;
+};
+
+// 16 bit move used by the table, from, to and promotion piece
+inline uint16_t encodeMove(const BitMove &move)
+{
+    return (uint16_t)(move.from | (move.to << 6) | (move.promotion() << 12));
+}
+
+class TranspositionTable
+{
+public:
+    TranspositionTable();
+    ~TranspositionTable();
+
+    TranspositionTable(const TranspositionTable &) = delete;
+    TranspositionTable &operator=(const TranspositionTable &) = delete;
+
+    // reallocate to the largest power of two bucket count that fits, this also clears it
+    void resize(size_t megabytes);
+    void clear();
+    size_t sizeInMegabytes() const { return _bucketCount * sizeof(Bucket) / (1024 * 1024); }
+
+    // call once per search so entries from older searches are replaced first
+    void newSearch() { _generation = (uint8_t)((_generation + 1) & kGenerationMask); }
+
+    bool probe(uint64_t key, TTData &data) const;
+    void store(uint64_t key, int depth, TTBound bound, int score, int eval, uint16_t move);
+
+    // start loading the bucket for key, call as soon as the child key is known
+    void prefetch(uint64_t key) const
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(&_buckets[key & _mask]);
+#endif
+    }
+
+    // permille of a sample of entries written by the current search, as uci reports it
+    int hashfull() const;
+
+private:
+    static constexpr int kBucketSize = 4;
+    static constexpr uint8_t kGenerationMask = 0x3f;
+
+    struct Entry
+    {
+        std::atomic<uint64_t> check;
+        std::atomic<uint64_t> data;
+    };
+
+    struct alignas(64) Bucket
+    {
+        Entry entries[kBucketSize];
+    };
+
+    // data layout: move 0-15, score 16-31, eval 32-47, depth 48-55, bound 56-57, generation 58-63
+    static uint64_t pack(uint16_t move, int score, int eval, int depth, int bound, int generation);
+    static void unpack(uint64_t data, TTData &out);
+    static int depthOf(uint64_t data) { return (int8_t)(data >> 48); }
+    static int generationOf(uint64_t data) { return (int)(data >> 58); }
+
+    Bucket *_buckets;
+    size_t _bucketCount;
+    size_t _mask;
+    uint8_t _generation;
+};
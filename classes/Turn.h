@@ -1,8 +1,6 @@
 #pragma once
-#include <iostream>
-
-class Game;
-class Player;
+#include <array>
+#include <cstdint>
 
 typedef enum {
 	kTurnEmpty,             // No action yet
@@ -11,23 +9,18 @@ typedef enum {
 	kTurnFinished           // Turn is confirmed and finished
 } TurnStatus;
 
-class Turn
+// the board after a turn, packed by Game::packState
+typedef std::array<uint8_t, 32> PackedState;
+
+// one entry of the turn history, a plain value so the whole history is one
+// contiguous vector with no allocation per turn
+struct Turn
 {
-public:
-	Turn() : _game(nullptr), _player(nullptr), _status(kTurnEmpty), _move(""), _boardState(""), _date(0), _comment(""), _score(0), _replaying(false), _gameNumber(-1) {};
-	~Turn() {};
+	static	Turn initStartOfGame(int gameNumber) { Turn turn; turn._status = kTurnFinished; turn._gameNumber = gameNumber; return turn; };
 
-	static	Turn *initStartOfGame(Game *game) { Turn *turn = new Turn(); turn->_game = game; turn->_status = kTurnFinished; return turn; };
-	void	setStateString(std::string board) { _boardState = board; };
-	Game		*_game;
-	Player		*_player;
-	TurnStatus	_status;
-	std::string	_move;
-	std::string	_boardState;
-	int			_date;
-	std::string	_comment;
-	int			_score;
-	bool		_replaying;
-	int			_gameNumber;
+	PackedState	_boardState = {};
+	TurnStatus	_status = kTurnEmpty;
+	int			_date = 0;
+	int			_score = 0;
+	int			_gameNumber = -1;
 };
-
@@ -0,0 +1,375 @@
+// Headless perft tool for the chess move generator
+//
+// usage:
+//   perft [--fen "<fen>"] [--depth N] [--divide] [--no-bulk] [--expect NODES]
+//         [--threads N] [--split 1|2] [--hash MB] [--sliders auto|magic|pext]
+//   perft --suite [--max-depth N] [--threads N] [--split 1|2] [--hash MB]
+//   perft --fen-check [--depth N]
+//   perft --fen-file PATH
+//
+// --fen      position to search, defaults to the start position
+// --depth    perft depth, defaults to 5
+// --divide   print the node count below each root move
+// --no-bulk  play out the last ply instead of counting the move list
+// --expect   exit with an error if the node count does not match (used by ctest)
+// --threads  run on a work stealing thread pool with this many threads
+// --split    1 hands out root moves, 2 hands out every reply to every root move
+// --hash     size in MB of a shared perft hash table, 0 to disable
+// --suite    run the built in standard positions and check their known counts
+// --fen-check  every position of the suite perft trees to --depth (default 3) must come back
+//              unchanged through the FEN writer and parser and through packing and unpacking,
+//              malformed FENs must be rejected, and a long game must keep its repetitions when
+//              its undo history is trimmed
+// --fen-file   load every line of a FEN or EPD file, report the bad ones and the load rate
+// --sliders  slider attack backend, auto picks pext on BMI2 CPUs, pext falls back to magic without it
+
+#include "classes/ChessFen.h"
+#include "classes/ChessMoveGen.h"
+#include "classes/ChessPacked.h"
+#include "classes/ChessPerft.h"
+#include "classes/MagicBitboards.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+static const char *kStartFEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+static void printUsage()
+{
+    std::cout << "usage: perft [--fen \"<fen>\"] [--depth N] [--divide] [--no-bulk] [--expect NODES]\n"
+              << "             [--threads N] [--split 1|2] [--hash MB] [--sliders auto|magic|pext]\n"
+              << "       perft --suite [--max-depth N] [--no-bulk] [--threads N] [--split 1|2] [--hash MB]\n"
+              << "       perft --fen-check [--depth N]\n"
+              << "       perft --fen-file PATH" << std::endl;
+}
+
+// run one perft and print nodes, time and nodes per second
+static uint64_t runPerft(const std::string &fen, int depth, bool divide, const PerftOptions &options)
+{
+    ChessPosition position;
+    FenResult result = parseFEN(fen, position);
+    if (!result.ok()) {
+        std::cerr << "invalid FEN at column " << result.offset + 1 << ": " << fenErrorMessage(result.error) << std::endl;
+        return 0;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    uint64_t nodes = 0;
+    bool parallel = options.threads > 1 || options.hashMegabytes > 0;
+    if (divide || parallel) {
+        std::vector<PerftDivideEntry> entries = parallel ? perftParallel(position, depth, options)
+                                                         : perftDivide(position, depth, options.bulkCount);
+        for (const PerftDivideEntry &entry : entries) {
+            if (divide) {
+                std::cout << moveToString(entry.move) << ": " << entry.nodes << std::endl;
+            }
+            nodes += entry.nodes;
+        }
+        if (divide) {
+            std::cout << std::endl;
+        }
+    } else {
+        nodes = perft(position, depth, options.bulkCount);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "depth " << depth << " nodes " << nodes
+              << " time " << (int)(seconds * 1000) << "ms"
+              << " nps " << (uint64_t)(seconds > 0 ? nodes / seconds : 0) << std::endl;
+    return nodes;
+}
+
+// write the position as a FEN and as a packed position, read both back and compare,
+// then do the same for every position below it
+static int roundTripTree(ChessPosition &position, int depth, uint64_t &checked)
+{
+    char buffer[FenBufferSize];
+    writeFEN(position, buffer);
+    ChessPosition copy;
+    int failures = 0;
+    if (!parseFEN(buffer, copy).ok() || copy.key() != position.key() || toFEN(copy) != buffer) {
+        std::cout << "round trip FAILED: " << buffer << std::endl;
+        failures++;
+    }
+    PackedPosition packed;
+    if (!packPosition(position, packed)) {
+        std::cout << "packing FAILED: " << buffer << std::endl;
+        failures++;
+    } else {
+        unpackPosition(packed, copy);
+        if (copy.key() != position.key() || toFEN(copy) != buffer) {
+            std::cout << "packed round trip FAILED: " << buffer << std::endl;
+            failures++;
+        }
+    }
+    checked++;
+    if (depth == 0) {
+        return failures;
+    }
+    MoveList moves;
+    generateLegalMoves(position, moves);
+    for (const BitMove &move : moves) {
+        position.makeMove(move);
+        failures += roundTripTree(position, depth - 1, checked);
+        position.unmakeMove(move);
+    }
+    return failures;
+}
+
+static int runFenCheck(int depth)
+{
+    int failures = 0;
+    uint64_t checked = 0;
+    for (int i = 0; i < kPerftSuiteSize; i++) {
+        ChessPosition position;
+        if (!position.setFromFEN(kPerftSuite[i].fen) || toFEN(position) != kPerftSuite[i].fen) {
+            std::cout << kPerftSuite[i].name << ": FAILED, does not write back as " << kPerftSuite[i].fen << std::endl;
+            failures++;
+            continue;
+        }
+        failures += roundTripTree(position, depth, checked);
+    }
+
+    struct BadFen
+    {
+        const char *fen;
+        FenError error;
+    };
+    static const BadFen kBadFens[] = {
+        { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBN w KQkq - 0 1", FenBadRankLength },
+        { "rnbqkbnr/ppppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", FenBadRankLength },
+        { "rnbqkbnr/pppppppp/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", FenBadRankCount },
+        { "rnbqkbnr/ppppxppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", FenBadPiece },
+        { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR x KQkq - 0 1", FenBadSideToMove },
+        { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkx - 0 1", FenBadCastling },
+        { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KKq - 0 1", FenBadCastling },
+        { "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e4 0 1", FenBadEnPassant },
+        { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - x 1", FenBadHalfmoveClock },
+        { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 99999", FenBadFullmoveNumber },
+        { "rnbq1bnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQ - 0 1", FenBadKings },
+        { "Pnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", FenPawnOnBackRank },
+        { "4k3/8/8/8/8/8/8/3K4 w K - 0 1", FenBadCastling },
+        { "4k3/8/8/8/8/8/8/4K3 w K - 0 1", FenBadCastling },
+        { "4k3/8/8/8/8/8/8/4R1K1 w - - 0 1", FenOpponentInCheck },
+        { "rnbqkbnr/pppppppp/pppppppp/8/8/PPPPPPPP/PPPPPPPP/RNBQKBNR w KQkq - 0 1", FenTooManyPieces },
+        { "4k3/8/8/8/8/N7/PPPPPPPP/QQQQKQQQ w - - 0 1", FenTooManyPieces },
+        { "4k3/8/8/8/8/P7/PPPPPPPP/4K3 w - - 0 1", FenTooManyPieces },
+    };
+    for (const BadFen &bad : kBadFens) {
+        ChessPosition position;
+        FenResult result = parseFEN(bad.fen, position);
+        if (result.error != bad.error) {
+            std::cout << "FAILED, expected \"" << fenErrorMessage(bad.error) << "\" but got \""
+                      << fenErrorMessage(result.error) << "\" for " << bad.fen << std::endl;
+            failures++;
+        }
+    }
+
+    // accepted, but written back without what does not fit the board
+    struct SanitisedFen
+    {
+        const char *fen;
+        const char *written;
+    };
+    static const SanitisedFen kSanitisedFens[] = {
+        { "4k3/8/8/4P3/8/8/8/4K3 w - d6 0 1", "4k3/8/8/4P3/8/8/8/4K3 w - - 0 1" },
+        { "4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1", "4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1" },
+        { "4k3/3p4/8/3pP3/8/8/8/4K3 w - d6 0 1", "4k3/3p4/8/3pP3/8/8/8/4K3 w - - 0 1" },
+    };
+    for (const SanitisedFen &sanitised : kSanitisedFens) {
+        ChessPosition position;
+        if (!parseFEN(sanitised.fen, position).ok() || toFEN(position) != sanitised.written) {
+            std::cout << "FAILED, " << sanitised.fen << " does not load as " << sanitised.written << std::endl;
+            failures++;
+        }
+    }
+
+    // more than 32 pieces only comes from building a position by hand, it must not pack
+    // into something that unpacks as a different position
+    {
+        ChessPosition crowded;
+        crowded.clear();
+        for (int square = 0; square < 48; square++) {
+            if (square != 4 && square != 44) {
+                crowded.putPiece(square, square < 24 ? White : Black, Knight);
+            }
+        }
+        crowded.putPiece(4, White, King);
+        crowded.putPiece(44, Black, King);
+        ChessPosition unpacked;
+        unpacked.setFromFEN(kPerftSuite[0].fen);
+        uint64_t key = unpacked.key();
+        PackedPosition packed;
+        if (packPosition(crowded, packed) || unpackPosition(packed, unpacked) || unpacked.key() != key) {
+            std::cout << "FAILED, a position with 48 pieces packs" << std::endl;
+            failures++;
+        }
+    }
+
+    // a long game keeps its repetitions when the undo stack runs full and is trimmed
+    {
+        ChessPosition shuffle;
+        shuffle.setFromFEN(kPerftSuite[0].fen);
+        const char *knights[] = { "g1f3", "g8f6", "f3g1", "f6g8" };
+        for (int ply = 0; ply < 2 * ChessPosition::MaxGamePly; ply++) {
+            MoveList moves;
+            generateLegalMoves(shuffle, moves);
+            for (const BitMove &move : moves) {
+                if (moveToString(move) == knights[ply % 4]) {
+                    shuffle.makeRoomInHistory(1);
+                    shuffle.makeMove(move);
+                    break;
+                }
+            }
+            if (ply >= 7 && !shuffle.isRepetition(shuffle.historyPly())) {
+                std::cout << "FAILED, repetition missed " << ply + 1 << " plies into a knight shuffle" << std::endl;
+                failures++;
+                break;
+            }
+        }
+    }
+
+    // parse and write speed, the suite positions over and over
+    const int rounds = 100000;
+    char buffer[FenBufferSize];
+    uint64_t checksum = 0;
+    ChessPosition position;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        parseFEN(kPerftSuite[round % kPerftSuiteSize].fen, position);
+        checksum += writeFEN(position, buffer) + position.key();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "fen round trips " << checked << " bad fens " << sizeof(kBadFens) / sizeof(kBadFens[0])
+              << " parse+write " << (uint64_t)(seconds > 0 ? rounds / seconds : 0) << "/s"
+              << " (checksum " << (checksum & 0xffff) << ")"
+              << " failures " << failures << std::endl;
+    return failures;
+}
+
+static int runFenFile(const char *path)
+{
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "cannot open " << path << std::endl;
+        return 2;
+    }
+    std::string line;
+    ChessPosition position;
+    uint64_t lines = 0;
+    uint64_t loaded = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (std::getline(file, line)) {
+        lines++;
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        FenResult result = parseFEN(line, position);
+        if (!result.ok()) {
+            std::cout << path << ":" << lines << ":" << result.offset + 1 << ": " << fenErrorMessage(result.error) << std::endl;
+            continue;
+        }
+        loaded++;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "loaded " << loaded << " of " << lines << " lines"
+              << " time " << (int)(seconds * 1000) << "ms"
+              << " rate " << (uint64_t)(seconds > 0 ? loaded / seconds : 0) << "/s" << std::endl;
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    std::string fen = kStartFEN;
+    int depth = 5;
+    int maxDepth = 0;
+    bool divide = false;
+    PerftOptions options;
+    bool suite = false;
+    bool fenCheck = false;
+    bool depthGiven = false;
+    const char *fenFile = nullptr;
+    bool hasExpected = false;
+    uint64_t expected = 0;
+
+    SliderBackend sliders = SliderAuto;
+
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--fen") && i + 1 < argc) {
+            fen = argv[++i];
+        } else if (!std::strcmp(argv[i], "--depth") && i + 1 < argc) {
+            depth = std::atoi(argv[++i]);
+            depthGiven = true;
+        } else if (!std::strcmp(argv[i], "--max-depth") && i + 1 < argc) {
+            maxDepth = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--expect") && i + 1 < argc) {
+            expected = std::strtoull(argv[++i], nullptr, 10);
+            hasExpected = true;
+        } else if (!std::strcmp(argv[i], "--sliders") && i + 1 < argc) {
+            i++;
+            sliders = !std::strcmp(argv[i], "magic") ? SliderMagic : !std::strcmp(argv[i], "pext") ? SliderPext : SliderAuto;
+        } else if (!std::strcmp(argv[i], "--threads") && i + 1 < argc) {
+            options.threads = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--split") && i + 1 < argc) {
+            options.splitDepth = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--hash") && i + 1 < argc) {
+            options.hashMegabytes = std::strtoull(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "--divide")) {
+            divide = true;
+        } else if (!std::strcmp(argv[i], "--no-bulk")) {
+            options.bulkCount = false;
+        } else if (!std::strcmp(argv[i], "--suite")) {
+            suite = true;
+        } else if (!std::strcmp(argv[i], "--fen-check")) {
+            fenCheck = true;
+        } else if (!std::strcmp(argv[i], "--fen-file") && i + 1 < argc) {
+            fenFile = argv[++i];
+        } else {
+            printUsage();
+            return 2;
+        }
+    }
+
+    initMagicBitboards(sliders);
+    std::cout << "slider attacks: " << sliderBackendName() << std::endl;
+
+    if (fenCheck) {
+        return runFenCheck(depthGiven ? depth : 3) ? 1 : 0;
+    }
+    if (fenFile) {
+        return runFenFile(fenFile);
+    }
+
+    if (suite) {
+        int failures = 0;
+        uint64_t totalNodes = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < kPerftSuiteSize; i++) {
+            const PerftSuiteEntry &entry = kPerftSuite[i];
+            int suiteDepth = (maxDepth > 0 && maxDepth < entry.depth) ? maxDepth : entry.depth;
+            std::cout << entry.name << ": ";
+            uint64_t nodes = runPerft(entry.fen, suiteDepth, false, options);
+            totalNodes += nodes;
+            if (suiteDepth == entry.depth && nodes != entry.nodes) {
+                std::cout << "  FAILED, expected " << entry.nodes << std::endl;
+                failures++;
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "suite nodes " << totalNodes
+                  << " nps " << (uint64_t)(seconds > 0 ? totalNodes / seconds : 0)
+                  << " failures " << failures << std::endl;
+        return failures ? 1 : 0;
+    }
+
+    uint64_t nodes = runPerft(fen, depth, divide, options);
+    if (hasExpected && nodes != expected) {
+        std::cout << "FAILED, expected " << expected << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,459 @@
+// Headless search tool for the chess engine
+//
+// usage:
+//   search [--fen "<fen>"] [--depth N] [--nodes N] [--hash MB] [--threads N]
+//          [--movetime MS | --wtime MS --btime MS [--winc MS] [--binc MS] [--movestogo N]]
+//          [--expect-move MOVE] [--expect-mate N] [--expect-draw] [--sliders auto|magic|pext] [feature switches]
+//   search --bench [--depth N] [--threads N] [--features] [--scaling] [--sliders auto|magic|pext]
+//          [feature switches]
+//   search --eval-check [--depth N] [--nnue FILE] [--simd scalar|sse41|avx2]
+//   search --eval-bench [--depth N] [--nnue FILE] [--simd scalar|sse41|avx2]
+//   search --nnue-export FILE
+//
+// --fen          position to search, defaults to the start position
+// --depth        iterative deepening depth, defaults to 6
+// --nodes        stop after about this many nodes
+// --hash         transposition table size in MB, defaults to 16
+// --threads      lazy SMP search threads, defaults to 1
+// --movetime     search exactly this long
+// --wtime ...    clock times and increments, the time manager decides how long to think
+//                with either, exit with an error if the search overstepped its hard limit or
+//                stopped before its soft limit allowed
+// --expect-move  exit with an error unless this uci move is chosen (used by ctest)
+// --expect-mate  exit with an error unless a mate in N moves is reported
+// --expect-draw  exit with an error unless the score is 0
+// --bench        fixed depth search of the standard positions, prints the total node count
+// --features     with --bench, rerun it with each selective feature switched off in turn
+// --scaling      with --bench, time to depth for 1, 2, 4 ... up to --threads threads
+// --sliders      slider attack backend, auto picks pext on BMI2 CPUs, pext falls back to magic without it
+// --eval-check   every position of the suite trees to --depth (default 3) must keep its incremental
+//                piece-square score and phase in step with a full recount, and evaluate the same as
+//                its color flipped mirror and with the pawn hash table, with --nnue the network's
+//                incremental accumulators must also match a rebuild and the plain C++ kernels
+// --eval-bench   evaluations per second over the same positions, hand written and with --nnue the network
+// --nnue         load a network file and evaluate with it instead of the hand written terms
+// --simd         limit the network's kernels, by default the best the CPU has
+// --nnue-export  write a network distilled from the piece-square tables, see writePsqtNnue
+//
+// feature switches: --no-null --no-lmr --no-rfp --no-futility --no-lmp --no-razor
+
+#include "classes/ChessEval.h"
+#include "classes/ChessFen.h"
+#include "classes/ChessNnue.h"
+#include "classes/ChessMoveGen.h"
+#include "classes/ChessPerft.h"
+#include "classes/ChessLazySmp.h"
+#include "classes/ChessTimeManager.h"
+#include "classes/MagicBitboards.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+static const char *kStartFEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+// stopping takes a node poll and joining the helper threads past the hard limit
+static const int kHardLimitSlack = 50;
+
+static void printUsage()
+{
+    std::cout << "usage: search [--fen \"<fen>\"] [--depth N] [--nodes N] [--hash MB] [--threads N]\n"
+              << "              [--movetime MS | --wtime MS --btime MS [--winc MS] [--binc MS] [--movestogo N]]\n"
+              << "              [--expect-move MOVE] [--expect-mate N] [--expect-draw] [--sliders auto|magic|pext] [feature switches]\n"
+              << "       search --bench [--depth N] [--threads N] [--features] [--scaling] [--sliders auto|magic|pext]\n"
+              << "              [feature switches]\n"
+              << "       search --eval-check [--depth N] [--nnue FILE] [--simd scalar|sse41|avx2]\n"
+              << "       search --eval-bench [--depth N] [--nnue FILE] [--simd scalar|sse41|avx2]\n"
+              << "       search --nnue-export FILE\n"
+              << "feature switches: --no-null --no-lmr --no-rfp --no-futility --no-lmp --no-razor" << std::endl;
+}
+
+static bool parseFeatureSwitch(const char *arg, SearchOptions &options)
+{
+    if (!std::strcmp(arg, "--no-null")) {
+        options.nullMove = false;
+    } else if (!std::strcmp(arg, "--no-lmr")) {
+        options.lateMoveReductions = false;
+    } else if (!std::strcmp(arg, "--no-rfp")) {
+        options.reverseFutility = false;
+    } else if (!std::strcmp(arg, "--no-futility")) {
+        options.futility = false;
+    } else if (!std::strcmp(arg, "--no-lmp")) {
+        options.lateMovePruning = false;
+    } else if (!std::strcmp(arg, "--no-razor")) {
+        options.razoring = false;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// fixed depth search of every suite position from a cleared table, so the node count
+// only changes when the search itself does
+// with more than one thread the count varies from run to run
+static uint64_t runBench(int depth, size_t hashMegabytes, int threads, const SearchOptions &options, bool verbose)
+{
+    TranspositionTable table;
+    table.resize(hashMegabytes);
+    LazySmpSearch search(table, threads);
+    search.setOptions(options);
+    search.onIteration = nullptr;
+    uint64_t totalNodes = 0;
+    EvalCounters counters;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kPerftSuiteSize; i++) {
+        ChessPosition position;
+        position.setFromFEN(kPerftSuite[i].fen);
+        table.clear();
+        SearchLimits limits;
+        limits.depth = depth;
+        SearchResult result = search.search(position, limits);
+        totalNodes += result.nodes;
+        counters += search.evalCounters();
+        if (verbose) {
+            std::cout << kPerftSuite[i].name << ": bestmove " << moveToString(result.bestMove)
+                      << " nodes " << result.nodes << std::endl;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "bench depth " << depth << " threads " << threads << " nodes " << totalNodes
+              << " time " << (int)(seconds * 1000) << "ms"
+              << " nps " << (uint64_t)(seconds > 0 ? totalNodes / seconds : 0)
+              << std::endl;
+    // how many evaluations the cache and the lazy estimate saved
+    auto percent = [](uint64_t part, uint64_t whole) { return whole ? 100.0 * part / whole : 0.0; };
+    uint64_t full = counters.evaluations - counters.cacheHits - counters.lazyExits;
+    std::cout << "  evals " << counters.evaluations << " cache hits " << percent(counters.cacheHits, counters.evaluations) << "%"
+              << " lazy " << percent(counters.lazyExits, counters.evaluations) << "%"
+              << " full " << full << " (" << percent(full, counters.evaluations) << "%)"
+              << " pawn hash hits " << percent(counters.pawnHits, counters.pawnProbes) << "%" << std::endl;
+    return totalNodes;
+}
+
+// the same position with the board flipped top to bottom and the colors swapped
+static void mirrorPosition(const ChessPosition &position, ChessPosition &mirror)
+{
+    mirror.clear();
+    for (int square = 0; square < 64; square++) {
+        int tag = position.pieceOn(square);
+        if (tag) {
+            mirror.putPiece(square ^ 56, pieceColorOf(tag) ^ 1, pieceTypeOf(tag));
+        }
+    }
+    mirror.setSideToMove(position.sideToMove() ^ 1);
+    int rights = position.castlingRights();
+    mirror.setCastlingRights(((rights & (WhiteKingSide | WhiteQueenSide)) << 2) | ((rights & (BlackKingSide | BlackQueenSide)) >> 2));
+    if (position.enPassantSquare() != NoSquare) {
+        mirror.setEnPassantSquare(position.enPassantSquare() ^ 56);
+    }
+}
+
+static int evalCheckTree(ChessPosition &position, int depth, uint64_t &checked, PawnHashTable &pawnTable, NnueEvaluator *nnue)
+{
+    int failures = 0;
+    ChessPosition mirror;
+    mirrorPosition(position, mirror);
+    checked++;
+    if (!(position.pieceSquare() == position.computePieceSquare()) || position.phase() != position.computePhase()) {
+        std::cout << "FAILED, incremental piece-square score or phase drifted in " << toFEN(position) << std::endl;
+        failures++;
+    } else if (evaluate(position) != evaluate(mirror)) {
+        std::cout << "FAILED, " << evaluate(position) << " but the mirror scores " << evaluate(mirror)
+                  << " in " << toFEN(position) << std::endl;
+        failures++;
+    } else if (evaluate(position, pawnTable) != evaluate(position)) {
+        std::cout << "FAILED, the pawn hash table changes the score of " << toFEN(position) << std::endl;
+        failures++;
+    } else if (nnue) {
+        int incremental = nnue->evaluate(position);
+        int rebuilt = NnueEvaluator::evaluateFromScratch(position);
+        NnueSimd simd = nnueSimd();
+        setNnueSimd(NnueScalar);
+        int scalar = NnueEvaluator::evaluateFromScratch(position);
+        setNnueSimd(simd);
+        if (incremental != rebuilt || rebuilt != scalar || rebuilt != NnueEvaluator::evaluateFromScratch(mirror)) {
+            std::cout << "FAILED, network scores " << incremental << " incrementally, " << rebuilt << " rebuilt, "
+                      << scalar << " with plain C++ and " << NnueEvaluator::evaluateFromScratch(mirror)
+                      << " for the mirror in " << toFEN(position) << std::endl;
+            failures++;
+        }
+    }
+    if (depth == 0 || failures) {
+        return failures;
+    }
+    MoveList moves;
+    generateLegalMoves(position, moves);
+    for (const BitMove &move : moves) {
+        if (nnue) {
+            nnue->push(position, move);
+        }
+        position.makeMove(move);
+        failures += evalCheckTree(position, depth - 1, checked, pawnTable, nnue);
+        position.unmakeMove(move);
+        if (nnue) {
+            nnue->pop();
+        }
+    }
+    return failures;
+}
+
+static int runEvalCheck(int depth, bool useNnue)
+{
+    int failures = 0;
+    uint64_t checked = 0;
+    PawnHashTable pawnTable;
+    NnueEvaluator nnue;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kPerftSuiteSize; i++) {
+        ChessPosition position;
+        position.setFromFEN(kPerftSuite[i].fen);
+        nnue.reset(position);
+        failures += evalCheckTree(position, depth, checked, pawnTable, useNnue ? &nnue : nullptr);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "eval check depth " << depth << " positions " << checked << " failures " << failures
+              << " time " << (int)(seconds * 1000) << "ms" << std::endl;
+    return failures;
+}
+
+// every position of the tree is evaluated where a search would, after walking to it with make/unmake
+template <typename Evaluate>
+static void evalBenchTree(ChessPosition &position, int depth, uint64_t &evaluations, NnueEvaluator &nnue, Evaluate evaluateAt)
+{
+    evaluations++;
+    volatile int score = evaluateAt(position);
+    (void)score;
+    if (depth == 0) {
+        return;
+    }
+    MoveList moves;
+    generateLegalMoves(position, moves);
+    for (const BitMove &move : moves) {
+        nnue.push(position, move);
+        position.makeMove(move);
+        evalBenchTree(position, depth - 1, evaluations, nnue, evaluateAt);
+        position.unmakeMove(move);
+        nnue.pop();
+    }
+}
+
+template <typename Evaluate>
+static void runEvalBench(const char *name, int depth, NnueEvaluator &nnue, Evaluate evaluateAt)
+{
+    uint64_t evaluations = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kPerftSuiteSize; i++) {
+        ChessPosition position;
+        position.setFromFEN(kPerftSuite[i].fen);
+        nnue.reset(position);
+        evalBenchTree(position, depth, evaluations, nnue, evaluateAt);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << name << ": " << evaluations << " evals time " << (int)(seconds * 1000) << "ms"
+              << " evals/s " << (uint64_t)(seconds > 0 ? evaluations / seconds : 0) << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    std::string fen = kStartFEN;
+    SearchLimits limits;
+    limits.depth = 6;
+    size_t hashMegabytes = 16;
+    std::string expectedMove;
+    int expectedMate = 0;
+    bool expectDraw = false;
+    SearchOptions options;
+    bool bench = false;
+    bool features = false;
+    bool depthGiven = false;
+    bool scaling = false;
+    bool evalCheck = false;
+    bool evalBench = false;
+    std::string nnueFile;
+    std::string nnueExport;
+    NnueSimd simd = NnueAvx2;
+    int threads = 1;
+
+    SliderBackend sliders = SliderAuto;
+
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--fen") && i + 1 < argc) {
+            fen = argv[++i];
+        } else if (!std::strcmp(argv[i], "--depth") && i + 1 < argc) {
+            limits.depth = std::atoi(argv[++i]);
+            depthGiven = true;
+        } else if (!std::strcmp(argv[i], "--nodes") && i + 1 < argc) {
+            limits.nodes = std::strtoull(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "--hash") && i + 1 < argc) {
+            hashMegabytes = std::strtoull(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "--movetime") && i + 1 < argc) {
+            limits.time.moveTime = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--wtime") && i + 1 < argc) {
+            limits.time.time[White] = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--btime") && i + 1 < argc) {
+            limits.time.time[Black] = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--winc") && i + 1 < argc) {
+            limits.time.increment[White] = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--binc") && i + 1 < argc) {
+            limits.time.increment[Black] = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--movestogo") && i + 1 < argc) {
+            limits.time.movesToGo = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--sliders") && i + 1 < argc) {
+            i++;
+            sliders = !std::strcmp(argv[i], "magic") ? SliderMagic : !std::strcmp(argv[i], "pext") ? SliderPext : SliderAuto;
+        } else if (!std::strcmp(argv[i], "--threads") && i + 1 < argc) {
+            threads = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--expect-move") && i + 1 < argc) {
+            expectedMove = argv[++i];
+        } else if (!std::strcmp(argv[i], "--expect-mate") && i + 1 < argc) {
+            expectedMate = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--expect-draw")) {
+            expectDraw = true;
+        } else if (!std::strcmp(argv[i], "--bench")) {
+            bench = true;
+        } else if (!std::strcmp(argv[i], "--features")) {
+            features = true;
+        } else if (!std::strcmp(argv[i], "--scaling")) {
+            scaling = true;
+        } else if (!std::strcmp(argv[i], "--eval-check")) {
+            evalCheck = true;
+        } else if (!std::strcmp(argv[i], "--eval-bench")) {
+            evalBench = true;
+        } else if (!std::strcmp(argv[i], "--nnue") && i + 1 < argc) {
+            nnueFile = argv[++i];
+            options.nnue = true;
+        } else if (!std::strcmp(argv[i], "--nnue-export") && i + 1 < argc) {
+            nnueExport = argv[++i];
+        } else if (!std::strcmp(argv[i], "--simd") && i + 1 < argc) {
+            i++;
+            simd = !std::strcmp(argv[i], "scalar") ? NnueScalar : !std::strcmp(argv[i], "sse41") ? NnueSse41 : NnueAvx2;
+        } else if (!parseFeatureSwitch(argv[i], options)) {
+            printUsage();
+            return 2;
+        }
+    }
+
+    initMagicBitboards(sliders);
+    std::cout << "slider attacks: " << sliderBackendName() << std::endl;
+
+    if (!nnueExport.empty()) {
+        if (!writePsqtNnue(nnueExport)) {
+            std::cerr << "cannot write " << nnueExport << std::endl;
+            return 1;
+        }
+        std::cout << "wrote " << nnueExport << std::endl;
+        return 0;
+    }
+    if (!nnueFile.empty()) {
+        std::string error;
+        if (!loadNnue(nnueFile, error)) {
+            std::cerr << error << std::endl;
+            return 2;
+        }
+        setNnueSimd(simd);
+        std::cout << "nnue: " << nnueFile << " (" << nnueSimdName() << ")" << std::endl;
+    }
+
+    if (evalCheck) {
+        return runEvalCheck(depthGiven ? limits.depth : 3, options.nnue) ? 1 : 0;
+    }
+    if (evalBench) {
+        int benchDepth = depthGiven ? limits.depth : 3;
+        PawnHashTable pawnTable;
+        NnueEvaluator nnue;
+        runEvalBench("hand written", benchDepth, nnue, [](const ChessPosition &position) { return evaluate(position); });
+        runEvalBench("hand written, pawn hash", benchDepth, nnue, [&](const ChessPosition &position) { return evaluate(position, pawnTable); });
+        if (options.nnue) {
+            runEvalBench("nnue", benchDepth, nnue, [&](const ChessPosition &position) { return nnue.evaluate(position); });
+            runEvalBench("nnue from scratch", benchDepth, nnue, [](const ChessPosition &position) { return NnueEvaluator::evaluateFromScratch(position); });
+        }
+        return 0;
+    }
+
+    if (bench) {
+        int benchDepth = depthGiven ? limits.depth : 12;
+        if (scaling) {
+            // lazy SMP is judged on time to depth, not node count
+            for (int count = 1;; count = std::min(count * 2, threads)) {
+                runBench(benchDepth, hashMegabytes, count, options, false);
+                if (count >= threads) {
+                    break;
+                }
+            }
+            return 0;
+        }
+        uint64_t nodes = runBench(benchDepth, hashMegabytes, threads, options, !features);
+        if (features) {
+            // each feature's saving is the extra nodes the bench needs without it
+            const char *names[] = { "null move", "late move reductions", "reverse futility",
+                                    "futility", "late move pruning", "razoring" };
+            bool SearchOptions::*switches[] = { &SearchOptions::nullMove, &SearchOptions::lateMoveReductions,
+                                                &SearchOptions::reverseFutility, &SearchOptions::futility,
+                                                &SearchOptions::lateMovePruning, &SearchOptions::razoring };
+            for (int i = 0; i < 6; i++) {
+                if (!(options.*switches[i])) {
+                    continue;
+                }
+                SearchOptions without = options;
+                without.*switches[i] = false;
+                std::cout << "without " << names[i] << ": ";
+                uint64_t withoutNodes = runBench(benchDepth, hashMegabytes, threads, without, false);
+                std::cout << "  saves " << (int64_t)(withoutNodes - nodes) << " nodes" << std::endl;
+            }
+        }
+        return 0;
+    }
+
+    ChessPosition position;
+    FenResult fenResult = parseFEN(fen, position);
+    if (!fenResult.ok()) {
+        std::cerr << "invalid FEN at column " << fenResult.offset + 1 << ": " << fenErrorMessage(fenResult.error) << std::endl;
+        return 2;
+    }
+
+    TranspositionTable table;
+    table.resize(hashMegabytes);
+    LazySmpSearch search(table, threads);
+    search.setOptions(options);
+    // with a clock the search stops on time, not depth
+    if (limits.time.isLimited() && !depthGiven) {
+        limits.depth = MaxSearchPly;
+    }
+    auto start = std::chrono::steady_clock::now();
+    SearchResult result = search.search(position, limits);
+    int elapsed = (int)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "bestmove " << moveToString(result.bestMove) << " depth " << result.depth
+              << " time " << elapsed << "ms" << std::endl;
+
+    int failures = 0;
+    if (limits.time.isLimited()) {
+        // the limits the search worked to, the clock started a moment before ours
+        TimeManager budget;
+        budget.start(limits.time, position.sideToMove());
+        // a fixed move time is used in full, a clock search stops no earlier than the
+        // most settled iteration may, see TimeManager::shouldStopAfterIteration
+        int64_t earliest = limits.time.moveTime > 0 ? budget.hardLimit() : budget.softLimit() * 70 / 100 * 6 / 10;
+        std::cout << "soft limit " << budget.softLimit() << "ms hard limit " << budget.hardLimit() << "ms" << std::endl;
+        if (elapsed > budget.hardLimit() + kHardLimitSlack) {
+            std::cout << "FAILED, overstepped the hard limit" << std::endl;
+            failures++;
+        } else if (elapsed < earliest && result.depth < limits.depth && std::abs(result.score) < ScoreMateInMaxPly) {
+            std::cout << "FAILED, stopped " << earliest - elapsed << "ms early" << std::endl;
+            failures++;
+        }
+    }
+    if (!expectedMove.empty() && moveToString(result.bestMove) != expectedMove) {
+        std::cout << "FAILED, expected " << expectedMove << std::endl;
+        failures++;
+    }
+    if (expectedMate && result.score != ScoreMate - (2 * expectedMate - 1)) {
+        std::cout << "FAILED, expected mate in " << expectedMate << std::endl;
+        failures++;
+    }
+    if (expectDraw && result.score != 0) {
+        std::cout << "FAILED, expected a draw" << std::endl;
+        failures++;
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,315 @@
+// UCI front-end for the chess engine, built without ImGui or GLFW
+//
+// reads commands from stdin and answers on stdout, so any UCI graphical interface
+// or match runner can play it
+//
+// supported commands:
+//   uci, isready, ucinewgame, quit
+//   setoption name Hash value MB | Threads value N | MultiPV value N | Move Overhead value MS
+//             | EvalFile value PATH | Use NNUE value true|false
+//   position startpos | fen <fen> [moves <move> ...]
+//   go [depth N] [nodes N] [movetime MS] [wtime MS] [btime MS] [winc MS] [binc MS]
+//      [movestogo N] [infinite] [ponder]
+//   stop, ponderhit
+//
+// the search runs on its own thread so stop and ponderhit are read while it thinks,
+// after go infinite or go ponder bestmove is held back until stop or ponderhit
+
+#include "classes/ChessFen.h"
+#include "classes/ChessMoveGen.h"
+#include "classes/ChessLazySmp.h"
+#include "classes/ChessNnue.h"
+#include "classes/MagicBitboards.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+static const char *kStartFEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+class UciEngine
+{
+public:
+    UciEngine() : _search(_table), _threads(1), _multiPV(1), _moveOverhead(10), _cancel(false), _pondering(false), _infinite(false)
+    {
+        _table.resize(16);
+        _position.setFromFEN(kStartFEN);
+        _search.onIteration = [this](const SearchInfo &info) {
+            std::lock_guard<std::mutex> lock(_outputMutex);
+            ChessSearch::printInfo(info);
+        };
+    }
+
+    ~UciEngine() { stopSearch(); }
+
+    // false once quit is read
+    bool handle(const std::string &line);
+    // at the end of the input a limited search is allowed to finish, an open ended one is stopped
+    void finish();
+
+private:
+    void send(const std::string &text);
+    void setOption(std::istringstream &input);
+    void setPosition(std::istringstream &input);
+    void go(std::istringstream &input);
+    void stopSearch();
+
+    TranspositionTable _table;
+    LazySmpSearch _search;
+    ChessPosition _position;
+    int _threads;
+    int _multiPV;
+    int _moveOverhead;
+    SearchOptions _options;
+
+    std::thread _worker;
+    std::mutex _outputMutex;
+    std::atomic<bool> _cancel;
+    // true while a ponder search waits for ponderhit, read by the search as its clock switch
+    std::atomic<bool> _pondering;
+    std::atomic<bool> _infinite;
+};
+
+void UciEngine::send(const std::string &text)
+{
+    std::lock_guard<std::mutex> lock(_outputMutex);
+    std::cout << text << std::endl;
+}
+
+bool UciEngine::handle(const std::string &line)
+{
+    std::istringstream input(line);
+    std::string command;
+    input >> command;
+
+    if (command == "uci") {
+        send("id name chess-base\n"
+             "id author chess-base\n"
+             "option name Hash type spin default 16 min 1 max 4096\n"
+             "option name Threads type spin default 1 min 1 max 256\n"
+             "option name MultiPV type spin default 1 min 1 max 64\n"
+             "option name Move Overhead type spin default 10 min 0 max 5000\n"
+             "option name EvalFile type string default <empty>\n"
+             "option name Use NNUE type check default false\n"
+             "uciok");
+    } else if (command == "isready") {
+        send("readyok");
+    } else if (command == "ucinewgame") {
+        stopSearch();
+        _table.clear();
+    } else if (command == "setoption") {
+        setOption(input);
+    } else if (command == "position") {
+        stopSearch();
+        setPosition(input);
+    } else if (command == "go") {
+        stopSearch();
+        go(input);
+    } else if (command == "stop") {
+        _infinite.store(false);
+        _pondering.store(false);
+        _cancel.store(true);
+    } else if (command == "ponderhit") {
+        // the clock starts now, and the search may answer as soon as it is done
+        _pondering.store(false);
+    } else if (command == "quit") {
+        stopSearch();
+        return false;
+    } else if (!command.empty()) {
+        send("info string unknown command " + command);
+    }
+    return true;
+}
+
+void UciEngine::setOption(std::istringstream &input)
+{
+    // option names may contain spaces, everything between name and value is the name
+    std::string word, name, value;
+    input >> word;
+    while (input >> word && word != "value") {
+        name += (name.empty() ? "" : " ") + word;
+    }
+    // a path may contain spaces too
+    std::getline(input >> std::ws, value);
+    std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+    int number = std::atoi(value.c_str());
+
+    stopSearch();
+    if (name == "hash") {
+        _table.resize((size_t)std::clamp(number, 1, 4096));
+    } else if (name == "threads") {
+        _threads = std::clamp(number, 1, 256);
+        _search.setThreadCount(_threads);
+        // new threads start from the default options
+        _search.setOptions(_options);
+    } else if (name == "multipv") {
+        _multiPV = std::clamp(number, 1, 64);
+    } else if (name == "move overhead") {
+        _moveOverhead = std::clamp(number, 0, 5000);
+    } else if (name == "evalfile") {
+        std::string error;
+        if (loadNnue(value, error)) {
+            send(std::string("info string loaded ") + value + " (" + nnueSimdName() + ")");
+        } else {
+            send("info string " + error);
+        }
+    } else if (name == "use nnue") {
+        _options.nnue = value == "true";
+        if (_options.nnue && !nnueLoaded()) {
+            send("info string no network loaded, set EvalFile first");
+        }
+        _search.setOptions(_options);
+    } else {
+        send("info string unknown option " + name);
+    }
+}
+
+void UciEngine::setPosition(std::istringstream &input)
+{
+    std::string word, fen;
+    input >> word;
+    if (word == "startpos") {
+        fen = kStartFEN;
+        input >> word;
+    } else if (word == "fen") {
+        while (input >> word && word != "moves") {
+            fen += (fen.empty() ? "" : " ") + word;
+        }
+    } else {
+        send("info string expected startpos or fen");
+        return;
+    }
+
+    ChessPosition position;
+    FenResult result = parseFEN(fen, position);
+    if (!result.ok()) {
+        send("info string invalid fen at column " + std::to_string(result.offset + 1) + ": " + fenErrorMessage(result.error));
+        return;
+    }
+    while (input >> word) {
+        MoveList moves;
+        generateLegalMoves(position, moves);
+        const BitMove *found = nullptr;
+        for (const BitMove &move : moves) {
+            if (moveToString(move) == word) {
+                found = &move;
+                break;
+            }
+        }
+        if (!found) {
+            send("info string illegal move " + word);
+            break;
+        }
+        position.makeRoomInHistory(1);
+        position.makeMove(*found);
+    }
+    _position = position;
+}
+
+void UciEngine::go(std::istringstream &input)
+{
+    SearchLimits limits;
+    limits.time.moveOverhead = _moveOverhead;
+    limits.multiPV = _multiPV;
+    bool depthGiven = false;
+    bool infinite = false;
+    bool ponder = false;
+
+    std::string word;
+    while (input >> word) {
+        int value = 0;
+        if (word == "infinite") {
+            infinite = true;
+        } else if (word == "ponder") {
+            ponder = true;
+        } else if (word == "nodes") {
+            input >> limits.nodes;
+        } else if (input >> value) {
+            if (word == "depth") {
+                limits.depth = value;
+                depthGiven = true;
+            } else if (word == "movetime") {
+                limits.time.moveTime = value;
+            } else if (word == "wtime") {
+                limits.time.time[White] = value;
+            } else if (word == "btime") {
+                limits.time.time[Black] = value;
+            } else if (word == "winc") {
+                limits.time.increment[White] = value;
+            } else if (word == "binc") {
+                limits.time.increment[Black] = value;
+            } else if (word == "movestogo") {
+                limits.time.movesToGo = value;
+            }
+        }
+    }
+    if (!depthGiven) {
+        limits.depth = MaxSearchPly - 1;
+    }
+    if (infinite) {
+        limits.time = TimeControl();
+    }
+
+    _cancel.store(false);
+    _infinite.store(infinite);
+    _pondering.store(ponder);
+    limits.cancel = &_cancel;
+    limits.pondering = &_pondering;
+
+    ChessPosition position = _position;
+    _worker = std::thread([this, position, limits]() {
+        SearchResult result = _search.search(position, limits);
+        // uci never lets bestmove come before stop or ponderhit
+        while ((_infinite.load() || _pondering.load()) && !_cancel.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        std::string reply = "bestmove " + (result.bestMove.piece != NoPiece ? moveToString(result.bestMove) : std::string("0000"));
+        if (result.ponderMove.piece != NoPiece) {
+            reply += " ponder " + moveToString(result.ponderMove);
+        }
+        send(reply);
+    });
+}
+
+void UciEngine::finish()
+{
+    if (_infinite.load() || _pondering.load()) {
+        _cancel.store(true);
+    }
+    if (_worker.joinable()) {
+        _worker.join();
+    }
+}
+
+void UciEngine::stopSearch()
+{
+    if (_worker.joinable()) {
+        _infinite.store(false);
+        _pondering.store(false);
+        _cancel.store(true);
+        _worker.join();
+    }
+}
+
+int main()
+{
+    initMagicBitboards();
+    // a uci interface reads every line as soon as it is written
+    std::cout.setf(std::ios::unitbuf);
+
+    UciEngine engine;
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        if (!engine.handle(line)) {
+            return 0;
+        }
+    }
+    engine.finish();
+    return 0;
+}